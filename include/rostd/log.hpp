@@ -0,0 +1,477 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_LOG_HPP
+#define ROSTD_LOG_HPP
+
+#include <rostd/printx.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <source_location>
+#include <string>
+#include <string_view>
+
+namespace rostd {
+namespace printx {
+
+/**
+ * A lock-free token bucket that admits at most `PerSecond` events per second
+ * on average, with bursts of up to `PerSecond` events. It is implemented as a
+ * "generic cell rate algorithm": rather than counting tokens, it tracks the
+ * theoretical arrival time of the next event, so admission is a single
+ * compare-and-swap. The whole limiter occupies exactly one cache line and is
+ * constant-initialized, so it can be a function-local static without a guard.
+ */
+template <unsigned PerSecond>
+    requires (PerSecond > 0 && PerSecond <= 1'000'000'000)
+class alignas(64) rate_limiter {
+public:
+    constexpr rate_limiter() noexcept = default;
+
+    // Returns true if the event is admitted. When it is, `suppressed` receives
+    // the number of events that were rejected since the last admitted one.
+    bool try_acquire(std::uint64_t& suppressed) noexcept {
+        using namespace std::chrono;
+        auto const now = duration_cast<nanoseconds>(
+                steady_clock::now().time_since_epoch()).count();
+        auto expected = tat.load(std::memory_order_relaxed);
+        for (;;) {
+            auto const start = expected > now ? expected : now;
+            if (start - now > tolerance) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (tat.compare_exchange_weak(expected, start + interval,
+                                          std::memory_order_relaxed))
+                break;
+        }
+        suppressed = dropped.load(std::memory_order_relaxed) == 0 ? 0
+                : dropped.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static constexpr std::int64_t period = 1'000'000'000; // nanoseconds
+    static constexpr std::int64_t interval = period / PerSecond;
+    static constexpr std::int64_t tolerance = period - interval;
+
+    std::atomic<std::int64_t> tat{0};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+static_assert(sizeof(rate_limiter<1>) == 64);
+
+/**
+ * The current time, printed with `%?` as a `system_clock` time would be
+ * (UTC, ISO 8601, with the fraction of a second that `Duration` holds):
+ *
+ *     rostd::fprintf<"%? %?\n">(stderr, printx::timestamp{}, message);
+ *
+ * The text is cached per thread. The calendar date and time of day are only
+ * formatted when the second changes; within a second, only the digits of the
+ * fraction are rewritten.
+ */
+template <typename Duration = std::chrono::microseconds>
+struct timestamp {};
+
+namespace detail {
+
+// The text of `now`, in a buffer of the calling thread that is valid until
+// its next call with the same `Duration`.
+template <typename Duration>
+char const* cached_time(std::chrono::sys_time<Duration> const now) noexcept {
+    struct cache {
+        std::chrono::sys_seconds second = std::chrono::sys_seconds::min();
+        std::size_t fraction = 0; // the offset of the fraction's digits
+        char text[48] = {};
+    };
+    constexpr auto digits = chrono::fraction_digits<typename Duration::period>;
+    thread_local auto cached = cache{};
+    auto const second = std::chrono::floor<std::chrono::seconds>(now);
+    if (second != cached.second) {
+        auto sink = buffer_sink{cached.text, sizeof cached.text};
+        auto const size = static_cast<std::size_t>(format_to<"%?">(sink, now));
+        cached.second = second;
+        cached.fraction = size - 1 - digits;
+    } else if constexpr (digits != 0) {
+        using unit = std::chrono::duration<std::int64_t, std::ratio<1,
+                digits == 3 ? 1'000 : digits == 6 ? 1'000'000 : 1'000'000'000>>;
+        auto fraction = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<unit>(now - second).count());
+        for (auto i = cached.fraction + digits; i-- != cached.fraction;
+                fraction /= 10)
+            cached.text[i] = static_cast<char>('0' + fraction % 10);
+    }
+    return cached.text;
+}
+
+template <typename Duration>
+struct traits<timestamp<Duration>> {
+    static auto fwd_args(timestamp<Duration>) noexcept {
+        return std::tuple{cached_time(std::chrono::floor<Duration>(
+                std::chrono::system_clock::now()))};
+    }
+    static constexpr auto spec = "s";
+};
+
+// Builds the format of the summary line that is emitted when a rate-limited
+// call site resumes output. The original format is quoted (without its
+// trailing newline) so that the summary can be traced to its call site.
+template <literal Fmt>
+consteval auto suppressed_fmt() noexcept {
+    constexpr char prefix[] = "suppressed %? messages like \"";
+    constexpr char suffix[] = "\"\n";
+    constexpr auto length = [] {
+        auto n = std::size_t{};
+        while (Fmt.data[n]) ++n;
+        if (n > 0 && Fmt.data[n - 1] == '\n') --n;
+        return n;
+    }();
+    constexpr auto escapes = [] {
+        auto n = std::size_t{};
+        for (std::size_t i = 0; i < length; ++i) n += Fmt.data[i] == '%';
+        return n;
+    }();
+    auto buffer = literal<sizeof prefix + length + escapes + sizeof suffix - 1>{};
+    auto out = buffer.data;
+    for (auto p = prefix; *p; *out++ = *p++) {}
+    for (std::size_t i = 0; i < length; ++i) {
+        if (Fmt.data[i] == '%') *out++ = '%';
+        *out++ = Fmt.data[i];
+    }
+    for (auto p = suffix; *p; *out++ = *p++) {}
+    return buffer;
+}
+
+constexpr std::string decimal(std::size_t n) {
+    auto digits = std::string{};
+    do { digits.insert(digits.begin(), static_cast<char>('0' + n % 10)); }
+    while (n /= 10);
+    return digits;
+}
+
+// Whether a character may be part of a field name in `json_text`.
+constexpr bool name_char(char const ch) noexcept {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')
+        || (ch >= '0' && ch <= '9') || ch == '_' || ch == '.' || ch == '-';
+}
+
+// The conversion that `%?` deduces for a value (for a range, an element).
+template <typename Arg>
+consteval char deduced_type(bool const range) noexcept {
+    auto spec = spec_of<Arg>();
+    if constexpr (concepts::element_range<Arg>)
+        if (range) spec = element_spec_of<Arg>();
+    return std::string_view{spec}.back();
+}
+
+// The JSON form of a format, as a format. A field `name=%conversion` becomes
+// a member "name", quoted and escaped as its value requires. The rest of the
+// text, including any other conversions, becomes the "msg" member. Every
+// conversion is given its argument's position, so that the members can be in
+// any order, and a trailing newline ends the object. Floating point members
+// print non-finite values as `null`, and a `bool` (passed as text by
+// `log_json`) prints as `true` or `false`.
+template <literal Fmt, typename... Args>
+constexpr std::string json_text() {
+    // The members of a sub-format are not one value, so they have no member
+    // of their own. That includes chrono durations and times: log their
+    // `count()` (or format them to text first) instead.
+    static_assert(!(concepts::composite<Args> || ...),
+            "types with a sub-format cannot be logged as JSON");
+    constexpr char types[] = {deduced_type<Args>(false)..., '\0'};
+    constexpr char element_types[] = {deduced_type<Args>(true)..., '\0'};
+    constexpr bool bools[] = {std::same_as<Args, bool>..., false};
+    auto const fmt = std::string_view{Fmt.data};
+    auto const escape = [](std::string& out, char const ch) {
+        switch (ch) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        case '\r': out += "\\r"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20) {
+                out += "\\u00";
+                out += "0123456789abcdef"[ch >> 4];
+                out += "0123456789abcdef"[ch & 15];
+            } else {
+                out += ch;
+            }
+        }
+    };
+    auto msg = std::string{}, fields = std::string{};
+    auto arg = std::size_t{};
+    for (std::size_t i = 0; i < fmt.size();) {
+        if (fmt[i] != '%') {
+            escape(msg, fmt[i++]);
+            continue;
+        }
+        if (fmt[i + 1] == '%') {
+            msg += "%%";
+            i += 2;
+            continue;
+        }
+        // A field's name is what precedes its '=' (and was copied to `msg`).
+        auto name = std::string{};
+        if (msg.ends_with('=')) {
+            auto j = msg.size() - 1;
+            while (j > 0 && name_char(msg[j - 1])) --j;
+            name = msg.substr(j, msg.size() - 1 - j);
+            if (!name.empty()) msg.resize(j);
+        }
+        ++i;
+        if (fmt[i] == '{') i = fmt.find('}', i) + 1; // escaped as JSON anyway
+        auto range = std::string{}, flags = std::string{}, spec = std::string{};
+        auto digits = i;
+        while (fmt[digits] >= '0' && fmt[digits] <= '9') ++digits;
+        if (fmt[digits] == '[') {
+            auto const end = fmt.find(']', digits);
+            range = "[";
+            for (auto p = digits + 1; p < end; ++p) escape(range, fmt[p]);
+            range += ']';
+            i = end + 1;
+        }
+        while (std::string_view{"-+ #0"}.find(fmt[i]) != std::string_view::npos)
+            flags += fmt[i++];
+        for (auto const precision : {false, true}) {
+            if (precision) {
+                if (fmt[i] != '.') break;
+                spec += fmt[i++];
+            }
+            if (fmt[i] == '*') {
+                spec += '*' + decimal(++arg) + '$';
+                ++i;
+            }
+            while (fmt[i] >= '0' && fmt[i] <= '9') spec += fmt[i++];
+        }
+        while (std::string_view{"hljztLq"}.find(fmt[i]) != std::string_view::npos)
+            spec += fmt[i++];
+        auto const type = fmt[i++];
+        spec += type;
+        auto const value = arg++;
+        auto const deduced = type != '?' ? type
+                : range.empty() ? types[value] : element_types[value];
+        auto const position = '%' + decimal(value + 1) + '$';
+        auto const bare = std::string_view{"diufFeEgG"}.find(deduced)
+                != std::string_view::npos;
+        auto const floating = std::string_view{"fFeEgG"}.find(deduced)
+                != std::string_view::npos;
+        auto const text = deduced == 's' || deduced == 'c';
+        // A bare number may not have a sign of '+', leading zeros or a
+        // trailing '.', so those flags are dropped from its members.
+        auto number_flags = std::string{};
+        for (auto const flag : flags)
+            if (flag != '+' && flag != '#' && flag != '0') number_flags += flag;
+        if (deduced == 'n') { // prints nothing
+            msg += position + flags + spec;
+        } else if (bools[value] && range.empty()) { // "true" or "false"
+            if (name.empty()) {
+                msg += position + 's';
+            } else {
+                if (!fields.empty()) fields += ',';
+                fields += '"' + name + "\":" + position + 's';
+            }
+        } else if (name.empty()) { // part of the message
+            msg += position + (text ? "{json}" : "") + range + flags + spec;
+        } else {
+            if (!fields.empty()) fields += ',';
+            fields += '"' + name + "\":";
+            auto const json = floating ? "{json}" : "";
+            if (!range.empty() && bare)
+                fields += '[' + position + json + "[,]" + number_flags + spec + ']';
+            else if (bare)
+                fields += position + json + number_flags + spec;
+            else
+                fields += '"' + position + (text ? "{json}" : "")
+                        + range + flags + spec + '"';
+        }
+    }
+    if (msg.ends_with("\\n")) msg.resize(msg.size() - 2);
+    while (msg.ends_with(' ')) msg.pop_back();
+    while (msg.starts_with(' ')) msg.erase(0, 1);
+    auto text = std::string{"{"};
+    if (!msg.empty()) text += "\"msg\":\"" + msg + (fields.empty() ? "\"" : "\",");
+    return text + fields + "}\n";
+}
+
+// The arguments of `json_fmt`, as they are passed: a `bool` as its text.
+template <typename Arg>
+constexpr decltype(auto) json_arg(Arg const& arg) noexcept {
+    if constexpr (std::same_as<Arg, bool>) return arg ? "true" : "false";
+    else return (arg);
+}
+
+template <literal Fmt, typename... Args>
+inline constexpr auto json_fmt = [] {
+    constexpr auto size = json_text<Fmt, Args...>().size();
+    auto buffer = literal<size + 1>{};
+    auto const text = json_text<Fmt, Args...>();
+    for (std::size_t i = 0; i < size; ++i) buffer.data[i] = text[i];
+    return buffer;
+}();
+
+} // namespace detail
+
+enum class log_level { debug, info, warning, error };
+
+// Messages below this level are not written by `rostd::log`.
+inline std::atomic<log_level> log_threshold{log_level::debug};
+
+namespace detail {
+
+// "%? [file:line] LEVEL ", for the file name (without its directory) and line
+// of `Where()`, a `std::source_location`. The conversion is for a timestamp.
+template <log_level Level, auto Where>
+constexpr std::string log_prefix_text() {
+    constexpr auto where = Where();
+    constexpr char const* names[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+    auto file = std::string_view{where.file_name()};
+    file.remove_prefix(file.find_last_of("/\\") + 1);
+    auto text = std::string{"%? ["};
+    for (auto const ch : file) {
+        if (ch == '%') text += '%';
+        text += ch;
+    }
+    return text + ':' + decimal(where.line()) + "] "
+            + names[static_cast<int>(Level)] + ' ';
+}
+
+#if defined(ROSTD_PRINTX_REGISTRY)
+// Fills in the source location of the registry record of a log call's format,
+// which `rostd::fprintf` cannot know, during static initialization.
+template <auto Where, literal Fmt, typename... Args>
+struct located {
+    static inline bool const filled = [] {
+        auto& record = registration<Fmt, std::remove_cvref_t<Args>...>::record;
+        record.file = Where().file_name();
+        record.line = Where().line();
+        return true;
+    }();
+};
+#endif
+
+template <log_level Level, auto Where>
+inline constexpr auto log_prefix = [] {
+    constexpr auto size = log_prefix_text<Level, Where>().size();
+    auto buffer = literal<size + 1>{};
+    auto const text = log_prefix_text<Level, Where>();
+    for (std::size_t i = 0; i < size; ++i) buffer.data[i] = text[i];
+    return buffer;
+}();
+
+} // namespace detail
+} // namespace printx
+
+/**
+ * Writes a log line to `stderr`, prefixed with a timestamp, the file name and
+ * line of `Where()` (a `std::source_location`), and the level:
+ *
+ *     2024-02-29T13:05:07.042513Z [server.cpp:42] WARNING retrying fd 7
+ *
+ * The prefix is literal text concatenated with `Fmt` at compile time, so the
+ * line is written by a single `printf`-family call. `ROSTD_LOG` supplies the
+ * location of its call site, which is also recorded in the format registry.
+ */
+template <printx::log_level Level, auto Where, printx::literal Fmt,
+          typename... Args>
+inline int log(Args const&... args) noexcept {
+    if (Level < printx::log_threshold.load(std::memory_order_relaxed)) return 0;
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::log<Level, Where, Seq>(args...);
+                }, args...);
+    } else {
+        constexpr auto fmt = printx::detail::log_prefix<Level, Where> + Fmt;
+#if defined(ROSTD_PRINTX_REGISTRY)
+        (void)&printx::detail::located<Where, fmt, printx::timestamp<>,
+                Args...>::filled;
+#endif
+        return rostd::fprintf<fmt>(stderr, printx::timestamp<>{}, args...);
+    }
+}
+
+// Logs at `Level` (debug, info, warning or error) from this line:
+//
+//     ROSTD_LOG(warning, "retrying fd %?\n", fd);
+#define ROSTD_LOG(Level, Fmt, ...) \
+    ::rostd::log<::rostd::printx::log_level::Level, \
+            [] { return std::source_location::current(); }, Fmt>(__VA_ARGS__)
+
+namespace printx::detail {
+
+// The limiter of one call site of `rostd::log_ratelimited`. It is keyed by the
+// call site alone, so the types of the arguments do not matter.
+template <unsigned PerSecond, auto Site>
+inline constinit rate_limiter<PerSecond> site_limiter;
+
+} // namespace printx::detail
+
+/**
+ * Writes to `stderr` as `rostd::fprintf` would, but admits no more than
+ * `PerSecond` messages per second (with bursts of up to `PerSecond`) from
+ * each call site. When output resumes after messages were dropped, a
+ * "suppressed N messages" summary line is written first. (If no message is
+ * admitted again, the summary is never written.)
+ *
+ * `Site` tells call sites apart: its default is a lambda, which has a type of
+ * its own wherever a call uses the default. The limiter is a
+ * constant-initialized variable for each call site, so the cost of a
+ * suppressed message is a clock read and two relaxed atomic operations.
+ */
+template <printx::literal Fmt, unsigned PerSecond, auto Site = [] {},
+          typename... Args>
+inline int log_ratelimited(Args const&... args) noexcept {
+    auto& limiter = printx::detail::site_limiter<PerSecond, Site>;
+    auto suppressed = std::uint64_t{};
+    if (!limiter.try_acquire(suppressed)) [[unlikely]] return 0;
+    if (suppressed != 0) [[unlikely]] {
+        rostd::fprintf<printx::detail::suppressed_fmt<Fmt>()>(stderr,
+                suppressed);
+    }
+    return rostd::fprintf<Fmt>(stderr, args...);
+}
+
+/**
+ * Writes to `stderr` one JSON object for the message that `rostd::fprintf`
+ * would write, derived from the same format at compile time. Fields written
+ * as `name=%?` become members, and the rest of the text becomes "msg":
+ *
+ *     rostd::log_json<"request done user=%? latency_ms=%.1f\n">(user, ms);
+ *     // {"msg":"request done","user":"alice","latency_ms":12.5}
+ *
+ * Strings and characters are escaped as they are formatted, and floating
+ * point members that are not finite print as `null`. Such an object is
+ * printed by the native engine in a single pass. Objects with neither are
+ * printed by `std::fprintf`.
+ */
+template <printx::literal Fmt, typename... Args>
+inline int log_json(Args const&... args) noexcept {
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::log_json<Seq>(args...);
+                }, args...);
+    } else {
+        return rostd::fprintf<printx::detail::json_fmt<Fmt, Args...>>(stderr,
+                printx::detail::json_arg(args)...);
+    }
+}
+
+} // namespace rostd
+
+#endif // ROSTD_LOG_HPP
@@ -16,12 +16,33 @@
 #ifndef ROSTD_PRINTX_HPP
 #define ROSTD_PRINTX_HPP
 
+#include <array>
+#include <atomic>
 #include <concepts>
-#include <cstdio>
+#include <cstdint>
 #include <iterator>
+#include <span>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 
+// In freestanding mode (for targets without a usable C library `printf`),
+// `<cstdio>` is not used, and the `printf`-family wrappers are not provided.
+// Formatting is then done with the native engine, `<rostd/printx/engine.hpp>`.
+#if !defined(ROSTD_PRINTX_FREESTANDING)
+    #include <chrono>
+    #include <cstdio>
+#elif defined(ROSTD_PRINTX_INSTRUMENT)
+    #error "ROSTD_PRINTX_INSTRUMENT requires <cstdio>"
+#endif
+
+#if defined(ROSTD_PRINTX_INSTRUMENT)
+    #include <algorithm>
+    #include <bit>
+    #include <chrono>
+    #include <vector>
+#endif
+
 namespace rostd {
 
 /**
@@ -45,6 +66,22 @@ enum : unsigned {
     prints_as_pointer = 0b0010, // can be printed as pointer via `%p`
     forbid_precision  = 0b0100, // precision specifier not allowed
     record_position   = 0b1000, // can be used with `%n`
+    has_sub_format   = 0b10000, // printed with a format of its own
+    only_as_range   = 0b100000, // printed only with a range conversion
+    forbid_number_flags = 0b1000000, // flags other than '-' not allowed
+};
+
+// Groups of conversions. Not every output engine implements all of them, and
+// formats are checked against the conversions of the engine they are built for.
+enum : unsigned {
+    integer_conversions  = 0b00001, // %c %d %i %u %o %x %X
+    string_conversions   = 0b00010, // %s
+    pointer_conversions  = 0b00100, // %p
+    position_conversions = 0b01000, // %n
+    float_conversions    = 0b10000, // %f %F %e %E %g %G %a %A
+    all_conversions      = 0b11111, // every `printf` conversion
+    range_conversions   = 0b100000, // %[separator]... (native engine only)
+    escape_conversions = 0b1000000, // %{json}s %{c}s %{csv}s (native engine only)
 };
 
 template <typename> struct traits;
@@ -89,7 +126,7 @@ struct traits<Type> : traits<std::nullptr_t> {};
 // Enum types, printed as their underlying integer type
 template <typename Type> requires std::is_enum_v<Type>
 struct traits<Type> : traits<std::underlying_type_t<Type>> {
-    static auto fwd_args(Type const& e) {
+    static constexpr auto fwd_args(Type const& e) {
         return std::tuple{static_cast<std::underlying_type_t<Type>>(e)};
     }
 };
@@ -99,7 +136,7 @@ struct traits<Type> : traits<std::underlying_type_t<Type>> {
 template <typename Str>
     requires requires(Str s) { s.c_str(); }
 struct traits<Str> {
-    static auto fwd_args(Str const& arg) {
+    static constexpr auto fwd_args(Str const& arg) {
         return std::tuple{arg.c_str()};
     }
     static constexpr auto spec = "s";
@@ -111,6 +148,39 @@ template <typename Container>
 concept container_of_char = // container types with a value_type of char
         std::same_as<char, std::remove_cv_t<typename Container::value_type>>;
 
+template <typename Arg>
+concept forwards = // types whose traits forward other values in their place
+        requires(Arg const& arg) { traits<Arg>::fwd_args(arg); };
+
+template <typename Arg>
+concept composite = // types printed with a sub-format of their own
+        forwards<Arg> && requires { traits<Arg>::fmt; };
+
+template <typename Arg>
+concept renders = // types whose traits write their own text (see `rendered`)
+        !forwards<Arg> && requires(Arg const& arg, char* out) {
+            { traits<Arg>::capacity } -> std::convertible_to<std::size_t>;
+            { traits<Arg>::render(out, arg) } -> std::same_as<char*>;
+        };
+
+} // namespace concepts
+
+template <typename Range>
+using element_of = std::remove_cvref_t<
+        decltype(*std::data(std::declval<Range const&>()))>;
+
+namespace concepts {
+
+template <typename Range>
+concept element_range = // contiguous ranges of numbers or pointers
+        requires(Range const& r) { std::data(r); std::size(r); }
+        && (std::is_arithmetic_v<element_of<Range>>
+            || std::is_enum_v<element_of<Range>>
+            || std::is_pointer_v<element_of<Range>>)
+        && !std::same_as<element_of<Range>, char> // (strings, not ranges)
+        && !requires(Range const& r) { r.c_str(); } // (nor std::wstring)
+        && !renders<element_of<Range>>; // (such as 128-bit integers)
+
 } // namespace concepts
 
 // Structured to match types like `std::string_view` and `std::vector<char>`
@@ -118,7 +188,7 @@ template <concepts::container_of_char Str>
     requires (!requires(Str s) { s.c_str(); } // these are handled separately
             && requires(Str s) { std::data(s); std::size(s); })
 struct traits<Str> {
-    static auto fwd_args(Str const& arg) {
+    static constexpr auto fwd_args(Str const& arg) {
         return std::tuple{static_cast<int>(std::size(arg)), std::data(arg)};
     }
     static constexpr auto spec = ".*s";
@@ -127,10 +197,25 @@ struct traits<Str> {
     static constexpr auto flags = forbid_precision;
 };
 
+// Ranges of numbers (such as `std::vector<int>` and `std::span<double const>`)
+// are printed with a range conversion, `%[separator]?`, as are arrays.
+template <concepts::element_range Range>
+    requires (!std::is_array_v<Range>)
+struct traits<Range> {
+    static constexpr auto fwd_args(Range const& arg) {
+        return std::tuple{std::span<element_of<Range> const>{
+                std::data(arg), std::size(arg)}};
+    }
+    static constexpr auto spec = "p";
+    static constexpr auto flags = only_as_range;
+};
+
 // Detect the existence and value of the `flags` trait in a `traits`.
 template <typename Arg>
 constexpr auto flags() {
-    if constexpr (requires { traits<Arg>::flags; }) {
+    if constexpr (concepts::composite<Arg>) {
+        return has_sub_format;
+    } else if constexpr (requires { traits<Arg>::flags; }) {
         return traits<Arg>::flags;
     } else {
         return 0u;
@@ -139,17 +224,30 @@ constexpr auto flags() {
 
 enum class status {
     correct,
+    braces_not_supported,
+    braces_unmatched,
+    composite_needs_plain_conversion,
     conversion_lacks_type,
+    conversion_not_supported,
+    escape_needs_string,
+    escape_unknown,
     field_precision_needs_int,
     field_precision_not_allowed,
     field_width_needs_int,
+    flag_not_allowed,
     format_expects_char,
     format_expects_int_ptr,
     format_expects_ptr,
+    format_invalid_position,
     format_invalid_type,
+    format_mixed_positions,
     format_not_enough_args,
+    format_positions_not_supported,
     format_spurious_percent,
-    format_too_many_args
+    format_too_many_args,
+    range_expected,
+    range_invalid_separator,
+    range_needs_conversion
 };
 
 // This is how error messages are communicated. This code must perform error
@@ -163,35 +261,85 @@ constexpr char const* check_error(status const st) {
         }
     switch (st) {
     case status::correct: break;
+    case status::braces_not_supported:
+        PRINTX_ERROR("replacement field not supported by braces");
+    case status::braces_unmatched:
+        PRINTX_ERROR("unmatched '{' or '}' in braces format");
+    case status::composite_needs_plain_conversion:
+        PRINTX_ERROR("type with a sub-format must be printed with plain %?");
     case status::conversion_lacks_type:
         PRINTX_ERROR("conversion lacks type at end of format");
+    case status::conversion_not_supported:
+        PRINTX_ERROR("conversion not supported by this output engine");
+    case status::escape_needs_string:
+        PRINTX_ERROR("escaping applies only to %s and %c (and {json} to floats)");
+    case status::escape_unknown:
+        PRINTX_ERROR("unknown escaping (expected json, c or csv)");
     case status::field_precision_needs_int:
         PRINTX_ERROR("field precision specifier '.*' expects int");
     case status::field_precision_not_allowed:
         PRINTX_ERROR("field precision specifier not allowed for type");
     case status::field_width_needs_int:
         PRINTX_ERROR("field width specifier '*' expects int");
+    case status::flag_not_allowed:
+        PRINTX_ERROR("flag not allowed for type (only '-' is)");
     case status::format_expects_char:
         PRINTX_ERROR("format %c expects argument of type char");
     case status::format_expects_int_ptr:
         PRINTX_ERROR("format %n expects argument of type int*");
     case status::format_expects_ptr:
         PRINTX_ERROR("format %p expects argument of pointer type");
+    case status::format_invalid_position:
+        PRINTX_ERROR("argument positions in format start at 1");
     case status::format_invalid_type:
         PRINTX_ERROR("format expects argument of different type");
+    case status::format_mixed_positions:
+        PRINTX_ERROR("format mixes positional and sequential arguments");
     case status::format_not_enough_args:
         PRINTX_ERROR("not enough arguments for format");
+    case status::format_positions_not_supported:
+        PRINTX_ERROR("argument positions not supported by this function");
     case status::format_spurious_percent:
         PRINTX_ERROR("spurious trailing '%' in format");
     case status::format_too_many_args:
         PRINTX_ERROR("too many arguments for format");
+    case status::range_expected:
+        PRINTX_ERROR("format %[ expects a range of numbers or pointers");
+    case status::range_invalid_separator:
+        PRINTX_ERROR("range separator may not contain '%'");
+    case status::range_needs_conversion:
+        PRINTX_ERROR("range expects a %[separator] conversion");
     }
     return nullptr;
     #undef PRINTX_ERROR
 }
 
+// The spec of a type: for a type with a sub-format, its transformed form.
+template <typename Arg>
+constexpr char const* spec_of() noexcept;
+
+// The spec and flags of the elements of a range (null if it is not one).
+template <typename Arg>
+constexpr char const* element_spec_of() noexcept {
+    if constexpr (concepts::element_range<Arg>)
+        return traits<element_of<Arg>>::spec;
+    else
+        return nullptr;
+}
+
+template <typename Arg>
+constexpr unsigned element_flags_of() noexcept {
+    if constexpr (concepts::element_range<Arg>)
+        return flags<element_of<Arg>>();
+    else
+        return 0u;
+}
+
 class transformer {
 public:
+    // Only the given groups of conversions are accepted.
+    constexpr explicit transformer(unsigned const conversions = all_conversions)
+        : conversions{conversions} {}
     constexpr virtual ~transformer() = default;
 
     // On success, `status::correct` is returned and `src` points to the end of
@@ -206,7 +354,8 @@ private:
     template <typename... Args>
     constexpr status transform_priv(char const*& src) noexcept {
         constexpr specifier specifiers[] = {
-            specifier{traits<Args>::spec, flags<Args>()}...,
+            specifier{spec_of<Args>(), flags<Args>(),
+                      element_spec_of<Args>(), element_flags_of<Args>()}...,
             specifier{}
         };
         return find_specifier(src, specifiers);
@@ -237,9 +386,22 @@ private:
         }
     };
 
+    static constexpr unsigned conversion_group(char const ch) {
+        switch (ch) {
+        case 's': return string_conversions;
+        case 'p': return pointer_conversions;
+        case 'n': return position_conversions;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A': return float_conversions;
+        }
+        return integer_conversions;
+    }
+
     struct specifier {
         char const* spec = nullptr;
         unsigned flags = 0u;
+        char const* element = nullptr; // spec and flags of a range's elements
+        unsigned element_flags = 0u;
         constexpr explicit operator bool() const { return spec != nullptr; }
     };
 
@@ -251,6 +413,9 @@ private:
                                     specifier const*) noexcept;
     constexpr status transform_specifier(char const*& src,
                                          specifier const*) noexcept;
+    constexpr status append_sub_format(char const* fmt) noexcept;
+
+    unsigned conversions;
 };
 
 // The job of this function is to copy text verbatim until it finds a format
@@ -258,7 +423,14 @@ private:
 constexpr status transformer::find_specifier(char const*& src,
         specifier const* spec_array) noexcept {
     while (!at_end(src)) {
-        if (*src == '%') {
+        if (*src == '%' && src[1] != '%' && (spec_array->flags & has_sub_format)) {
+            if (src[1] != '?') return status::composite_needs_plain_conversion;
+            if (auto const st = append_sub_format(spec_array->spec);
+                    st != status::correct)
+                return st;
+            src += 2;
+            ++spec_array;
+        } else if (*src == '%') {
             append('%');
             if (at_end(++src))
                 return status::format_spurious_percent;
@@ -274,6 +446,22 @@ constexpr status transformer::find_specifier(char const*& src,
     return *spec_array ? status::format_too_many_args : status::correct;
 }
 
+// The sub-format of a composite argument has been transformed already, and is
+// spliced in whole. Its conversions must still be ones this engine supports.
+constexpr status transformer::append_sub_format(char const* fmt) noexcept {
+    for (auto in_conversion = false; *fmt; append(*fmt++)) {
+        if (*fmt == '%') {
+            if (fmt[1] == '%') append(*fmt++);
+            else in_conversion = true;
+        } else if (in_conversion && specifier_class{*fmt}) {
+            in_conversion = false;
+            if (!(conversion_group(*fmt) & conversions))
+                return status::conversion_not_supported;
+        }
+    }
+    return status::correct;
+}
+
 // There are potentially 3 arguments that match to a single format specifier:
 //   1) flags and the field width specifier ('*' consumes an argument)
 //   2) dot and the field precision specifier ('*' consumes an argument)
@@ -282,9 +470,45 @@ constexpr status transformer::transform_specifier(char const*& src,
         specifier const* spec_array) noexcept {
     if (!*spec_array) return status::format_not_enough_args;
 
+    // An escaping, which is copied verbatim.
+    auto const escape = *src == '{';
+    auto json = false;
+    if (escape) {
+        auto const name = ++src;
+        while (*src && *src != '}') ++src;
+        auto const mode = std::string_view{name,
+                static_cast<std::size_t>(src - name)};
+        if (!*src || (mode != "json" && mode != "c" && mode != "csv")) {
+            src = name - 1;
+            return status::escape_unknown;
+        }
+        json = mode == "json";
+        append('{');
+        for (auto p = name; p != src; append(*p++)) {}
+        append(*src++);
+    }
+
+    // A range conversion: an optional group size, then its separator, which
+    // are copied verbatim.
+    auto digits = src;
+    while (*digits >= '0' && *digits <= '9') ++digits;
+    auto const range = *digits == '[';
+    if (range) {
+        while (src != digits) append(*src++);
+        do {
+            if (*src == '%') return status::range_invalid_separator;
+            append(*src);
+            if (at_end(++src)) return status::conversion_lacks_type;
+        } while (src[-1] != ']');
+    }
+
     while (!at_end(src)) { // copy any flags directly
         switch (*src) {
-        case '-': case '+': case ' ': case '#': case '0':
+        case '+': case ' ': case '#': case '0':
+            if (spec_array->flags & forbid_number_flags)
+                return status::flag_not_allowed;
+            [[fallthrough]];
+        case '-':
             append(*src++);
             continue;
         }
@@ -324,6 +548,19 @@ constexpr status transformer::transform_specifier(char const*& src,
         }
     }
 
+    // A `*` may have moved on to a type with a sub-format, which must still
+    // be printed with a plain `%?`.
+    if (spec_array->flags & has_sub_format)
+        return status::composite_needs_plain_conversion;
+
+    // A range is printed element by element, each as the conversion says.
+    if (range && !spec_array->element) return status::range_expected;
+    if (!range && (spec_array->flags & only_as_range))
+        return status::range_needs_conversion;
+    auto const value = range
+            ? specifier{spec_array->element, spec_array->element_flags}
+            : *spec_array;
+
     // Length sub-specifier and type specifier are parsed together. Length
     // sub-specifiers are ignored (and replaced as necessary), and this is
     // equipped to ignore non-standard sub-specifiers as well, such as I32/I64.
@@ -331,23 +568,27 @@ constexpr status transformer::transform_specifier(char const*& src,
     for (int i = 1; i <= 4; ++i) { // this could not be more than 4 chars
         if (at_end(src)) return status::conversion_lacks_type;
         auto const ch = *src++;
+        if (ch == '$') { // positions are made sequential before transformation
+            --src;
+            return status::format_positions_not_supported;
+        }
         if (ch == '?') {
             // This is the special character that indicates that the format
             // specifier should be deduced.
-            for (auto p = spec_array->spec; *p; append(*p++)) {}
+            for (auto p = value.spec; *p; append(*p++)) {}
         } else if (auto const cl = specifier_class{ch}) {
             if (ch == 'c') { // %c takes no sub-specifiers
-                if (!(spec_array->flags & promotes_to_int))
+                if (!(value.flags & promotes_to_int))
                     return status::format_expects_char;
             } else if (ch == 'n') { // %n takes no sub-specifiers
-                if (!(spec_array->flags & record_position))
+                if (!(value.flags & record_position))
                     return status::format_expects_int_ptr;
             } else if (ch == 'p') { // %p takes no sub-specifiers
-                if (!(spec_array->flags & prints_as_pointer))
+                if (!(value.flags & prints_as_pointer))
                     return status::format_expects_ptr;
             } else {
                 // Sub-specifier is all but the last char of the specifier.
-                auto p = spec_array->spec;
+                auto p = value.spec;
                 for (auto next = p + 1; *next; ++next) append(*p++);
                 if (cl != *p) return status::format_invalid_type;
             }
@@ -355,6 +596,15 @@ constexpr status transformer::transform_specifier(char const*& src,
         } else {
             continue;
         }
+        auto type = ch; // the conversion, which may have been deduced
+        if (ch == '?') for (auto p = value.spec; *p; type = *p++) {}
+        if (!(conversion_group(type) & conversions)
+                || (range && (type == 'n' || !(range_conversions & conversions)))
+                || (escape && !(escape_conversions & conversions)))
+            return status::conversion_not_supported;
+        if (escape && !(json && (conversion_group(type) & float_conversions))
+                && (range || (type != 's' && type != 'c')))
+            return status::escape_needs_string;
         ++spec_array; // move to the next type
         return find_specifier(src, spec_array);
     }
@@ -364,21 +614,78 @@ constexpr status transformer::transform_specifier(char const*& src,
 
 // This counts the exact number of bytes that the transformed string will use.
 // (Does NOT include any null-terminator that may be needed.)
+// Counts every conversion: the appending pass rejects those that an engine
+// does not implement.
 struct counting_transformer : transformer {
     std::size_t count = 0;
-    constexpr ~counting_transformer() override = default;
+    constexpr counting_transformer() noexcept : transformer{~0u} {}
+    constexpr ~counting_transformer() override {}
     constexpr void append(char) override { ++count; }
 };
 
 class appending_transformer : public transformer {
 public:
-    constexpr appending_transformer(char* out) : out{out} {}
-    constexpr ~appending_transformer() override = default;
+    constexpr appending_transformer(char* out,
+            unsigned const conversions = all_conversions)
+        : transformer{conversions}, out{out} {}
+    constexpr ~appending_transformer() override {}
 private:
     constexpr void append(char c) override { *out++ = c; }
     char* out;
 };
 
+#if defined(__SIZEOF_INT128__)
+__extension__ using int128 = __int128;
+__extension__ using uint128 = unsigned __int128;
+
+namespace int128_digits {
+
+// Writes the digits of a 64-bit value backwards from `end`, and returns the
+// first; with `Width`, as exactly that many digits.
+template <int Width = 0>
+constexpr char* put_decimal(char* end, std::uint64_t value) noexcept {
+    if constexpr (Width == 0) {
+        do { *--end = static_cast<char>('0' + value % 10); } while (value /= 10);
+    } else {
+        for (auto i = 0; i < Width; ++i, value /= 10)
+            *--end = static_cast<char>('0' + value % 10);
+    }
+    return end;
+}
+
+// As above, for a 128-bit value in decimal ('d'), hex ('x' or 'X') or octal
+// ('o'). Decimal is converted 19 digits at a time with 64-bit arithmetic, so
+// that a value takes at most two 128-bit divisions (none, if it fits 64 bits).
+constexpr char* put(char* end, uint128 value, char const type) noexcept {
+    if (type == 'o') {
+        do { *--end = static_cast<char>('0' + (value & 7)); } while (value >>= 3);
+    } else if (type == 'x' || type == 'X') {
+        auto const digits = type == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+        do { *--end = digits[value & 15]; } while (value >>= 4);
+    } else {
+        constexpr auto chunk = std::uint64_t{10'000'000'000'000'000'000u};
+        while (value >> 64) {
+            auto const quotient = value / chunk;
+            end = put_decimal<19>(end,
+                    static_cast<std::uint64_t>(value - quotient * chunk));
+            value = quotient;
+        }
+        end = put_decimal(end, static_cast<std::uint64_t>(value));
+    }
+    return end;
+}
+
+// Copies the digits written to the end of `buffer` to `out`.
+template <std::size_t Size>
+constexpr char* copy(char* out, char const (&buffer)[Size],
+        char const* first) noexcept {
+    while (first != buffer + Size) *out++ = *first++;
+    return out;
+}
+
+} // namespace int128_digits
+#endif
+
 template <typename... Args>
 constexpr std::size_t count_size(char const* str) {
     auto cx = counting_transformer{};
@@ -389,17 +696,113 @@ constexpr std::size_t count_size(char const* str) {
 // A traits<> that has its own fwd_args() function is allowed to override
 // default behavior (which is just to pass the value through to the argument
 // list).
-template <typename Arg>
-    requires requires(Arg arg) { traits<Arg>::fwd_args(arg); }
-auto fwd_args(Arg const& arg) {
+template <concepts::forwards Arg>
+constexpr auto fwd_args(Arg const& arg) {
     return traits<Arg>::fwd_args(arg);
 }
 
 template <typename Arg>
-auto fwd_args(Arg const& arg) {
+constexpr auto fwd_args(Arg const& arg) {
     return std::tuple{arg};
 }
 
+// A traits<> may instead render the text of a value itself, with a kernel
+// that writes at most `capacity - 1` characters and returns the end:
+//
+//     static constexpr std::size_t capacity = 16;
+//     static char* render(char* out, Type const& value) noexcept;
+//
+// The text is passed to `printf` as a `%s` argument, from one of a ring of
+// thread-local slots (so a call may print up to `render_slots` values of the
+// same type; `invoke` rejects more at compile time). The native engine
+// renders it in its argument list instead.
+inline constexpr std::size_t render_slots = 16;
+
+template <concepts::renders Arg>
+auto fwd_args(Arg const& arg) noexcept {
+    thread_local char slots[render_slots][traits<Arg>::capacity];
+    thread_local std::size_t next = 0;
+    auto const slot = slots[next++ % render_slots];
+    *traits<Arg>::render(slot, arg) = '\0';
+    return std::tuple{static_cast<char const*>(slot)};
+}
+
+#if defined(__SIZEOF_INT128__)
+// 128-bit integers, in decimal; see `printx::hex` and `printx::octal` for the
+// other bases.
+template <>
+struct traits<uint128> {
+    static constexpr std::size_t capacity = 40;
+    static constexpr char* render(char* out, uint128 const value) noexcept {
+        char buffer[capacity - 1];
+        return int128_digits::copy(out, buffer,
+                int128_digits::put(buffer + sizeof buffer, value, 'd'));
+    }
+    static constexpr auto spec = "s";
+    // The digits are passed as a string, so the flags and precision of a
+    // number cannot apply to them.
+    static constexpr auto flags = forbid_precision | forbid_number_flags;
+};
+
+template <>
+struct traits<int128> {
+    static constexpr std::size_t capacity = 41;
+    static constexpr char* render(char* out, int128 const value) noexcept {
+        if (value < 0) *out++ = '-';
+        return traits<uint128>::render(out, value < 0
+                ? uint128{0} - static_cast<uint128>(value)
+                : static_cast<uint128>(value));
+    }
+    static constexpr auto spec = "s";
+    static constexpr auto flags = traits<uint128>::flags;
+};
+#endif
+
+// Text rendered by a traits<> kernel, as the native engine carries it.
+template <std::size_t Capacity>
+struct rendered {
+    char data[Capacity] = {};
+    std::size_t size = 0;
+};
+
+// A type with a sub-format forwards its members, each forwarded in turn.
+template <concepts::composite Arg>
+constexpr auto fwd_args(Arg const& arg) {
+    return std::apply([](auto const&... members) {
+            return std::tuple_cat(fwd_args(members)...);
+        }, traits<Arg>::fwd_args(arg));
+}
+
+// The members that a type with a sub-format forwards.
+template <typename Arg>
+using members_of = decltype(traits<Arg>::fwd_args(std::declval<Arg const&>()));
+
+// The name of a type as spelled by the compiler. This is only meant to be
+// human-readable and stable for a given compiler; it is not portable.
+template <typename Type>
+consteval std::string_view type_name() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+    auto const name = std::string_view{__PRETTY_FUNCTION__};
+    auto const first = name.find("Type = ") + 7;
+    auto const last = name.find_first_of(";]", first);
+#elif defined(_MSC_VER)
+    auto const name = std::string_view{__FUNCSIG__};
+    auto const first = name.find("type_name<") + 10;
+    auto const last = name.rfind(">(void)");
+#endif
+    return name.substr(first, last - first);
+}
+
+// 64-bit FNV-1a, used to derive stable identifiers at compile time.
+constexpr std::uint64_t fnv1a(std::string_view const str,
+        std::uint64_t hash = 0xcbf29ce484222325ull) noexcept {
+    for (auto const ch : str) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 0x100000001b3ull;
+    }
+    return (hash ^ 0xff) * 0x100000001b3ull; // separates successive strings
+}
+
 } // namespace detail
 
 namespace { // anonymous, internal linkage always
@@ -411,26 +814,1001 @@ struct literal {
     }
     char data[Size] = {};
 };
+
+// Literals are concatenated at compile time, so that formats can be composed
+// (as a prefix and a message) and still be a single literal format.
+template <std::size_t Size, std::size_t Other>
+consteval auto operator+(literal<Size> const& a, literal<Other> const& b) {
+    auto result = literal<Size + Other - 1>{};
+    for (std::size_t i = 0; i + 1 < Size; ++i) result.data[i] = a.data[i];
+    for (std::size_t i = 0; i < Other; ++i) result.data[Size - 1 + i] = b.data[i];
+    return result;
+}
+
+template <std::size_t Size, std::size_t Other>
+consteval auto operator+(char const (&a)[Size], literal<Other> const& b) {
+    return literal<Size>{a} + b;
+}
+
+template <std::size_t Size, std::size_t Other>
+consteval auto operator+(literal<Size> const& a, char const (&b)[Other]) {
+    return a + literal<Other>{b};
+}
 } // anonymous namespace
 
+namespace detail {
+
+// A literal is printed as the string it holds.
+template <std::size_t Size>
+struct traits<literal<Size>> : traits<char const*> {
+    static constexpr auto fwd_args(literal<Size> const& arg) {
+        return std::tuple{static_cast<char const*>(arg.data)};
+    }
+};
+
+} // namespace detail
+
+// Opts an aggregate type in to being printed with `%?`, field by field, as
+// `{field, field, ...}`. Fields are printed as they would be on their own.
+// Only simple aggregates are supported: at most 16 fields, and no arrays, bit
+// fields or base classes.
+template <typename Type>
+inline constexpr bool print_as_aggregate = false;
+
+#if defined(__SIZEOF_INT128__)
+// A 128-bit integer printed with `%?` in hex (`x` or `X`) or octal (`o`), as
+// `printx::hex(id)` or `printx::octal(mask)`. A negative value prints as its
+// 128-bit two's complement.
+template <char Type>
+struct radix {
+    detail::uint128 value;
+};
+
+template <char Type = 'x'>
+    requires (Type == 'x' || Type == 'X')
+constexpr radix<Type> hex(detail::uint128 const value) noexcept {
+    return {value};
+}
+
+constexpr radix<'o'> octal(detail::uint128 const value) noexcept {
+    return {value};
+}
+
+namespace detail {
+
+template <char Type>
+struct traits<radix<Type>> {
+    static constexpr std::size_t capacity = 44;
+    static constexpr char* render(char* out, radix<Type> const number) noexcept {
+        char buffer[capacity - 1];
+        return int128_digits::copy(out, buffer,
+                int128_digits::put(buffer + sizeof buffer, number.value, Type));
+    }
+    static constexpr auto spec = "s";
+    static constexpr auto flags = traits<uint128>::flags;
+};
+
+} // namespace detail
+#endif
+
+namespace detail {
+namespace aggregates {
+
+struct any_field {
+    template <typename Type> operator Type() const;
+};
+
+template <typename Type, std::size_t... I>
+constexpr bool initializable(std::index_sequence<I...>) noexcept {
+    return requires { Type{(void(I), any_field{})...}; };
+}
+
+inline constexpr std::size_t max_fields = 16;
+
+// The number of fields, as the most initializers the type accepts.
+template <typename Type, std::size_t Count = max_fields>
+constexpr std::size_t count_fields() noexcept {
+    if constexpr (Count == 0
+            || initializable<Type>(std::make_index_sequence<Count>{}))
+        return Count;
+    else
+        return count_fields<Type, Count - 1>();
+}
+
+template <std::size_t Count, typename Type>
+constexpr auto tie_fields(Type const& v) noexcept {
+    #define PRINTX_TIE(N, ...) \
+        else if constexpr (Count == N) { \
+            auto const& [__VA_ARGS__] = v; \
+            return std::tie(__VA_ARGS__); \
+        }
+    if constexpr (Count == 0) { return std::tuple{}; }
+    PRINTX_TIE(1, a)
+    PRINTX_TIE(2, a, b)
+    PRINTX_TIE(3, a, b, c)
+    PRINTX_TIE(4, a, b, c, d)
+    PRINTX_TIE(5, a, b, c, d, e)
+    PRINTX_TIE(6, a, b, c, d, e, f)
+    PRINTX_TIE(7, a, b, c, d, e, f, g)
+    PRINTX_TIE(8, a, b, c, d, e, f, g, h)
+    PRINTX_TIE(9, a, b, c, d, e, f, g, h, i)
+    PRINTX_TIE(10, a, b, c, d, e, f, g, h, i, j)
+    PRINTX_TIE(11, a, b, c, d, e, f, g, h, i, j, k)
+    PRINTX_TIE(12, a, b, c, d, e, f, g, h, i, j, k, l)
+    PRINTX_TIE(13, a, b, c, d, e, f, g, h, i, j, k, l, m)
+    PRINTX_TIE(14, a, b, c, d, e, f, g, h, i, j, k, l, m, n)
+    PRINTX_TIE(15, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o)
+    PRINTX_TIE(16, a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p)
+    #undef PRINTX_TIE
+}
+
+// "{%?, %?, ...}", with a conversion for each field.
+template <std::size_t Count>
+inline constexpr auto format_of = [] {
+    auto fmt = literal<Count ? 4 * Count + 1 : 3>{};
+    auto out = fmt.data;
+    *out++ = '{';
+    for (std::size_t i = 0; i < Count; ++i) {
+        if (i) *out++ = ',', *out++ = ' ';
+        *out++ = '%', *out++ = '?';
+    }
+    *out = '}';
+    return fmt;
+}();
+
+} // namespace aggregates
+
+// Aggregates that opt in are printed with a sub-format of their fields.
+template <typename Type>
+    requires (print_as_aggregate<Type> && std::is_aggregate_v<Type>)
+struct traits<Type> {
+    static_assert(!aggregates::initializable<Type>(
+            std::make_index_sequence<aggregates::max_fields + 1>{}),
+            "too many fields to print as an aggregate");
+    static constexpr auto fields = aggregates::count_fields<Type>();
+    static constexpr auto fmt = aggregates::format_of<fields>;
+    static constexpr auto fwd_args(Type const& v) noexcept {
+        return aggregates::tie_fields<fields>(v);
+    }
+};
+
+#if !defined(ROSTD_PRINTX_FREESTANDING) // <chrono> brings in the C library
+namespace chrono {
+
+// "%?" and the unit of a period, such as "ms". A period without a name is
+// given as a ratio of seconds, as "[1/30]s".
+template <typename Period>
+inline constexpr auto duration_fmt = [] {
+    auto fmt = literal<48>{};
+    auto out = fmt.data;
+    auto const put = [&](std::string_view const text) {
+        for (auto const ch : text) *out++ = ch;
+    };
+    auto const put_number = [&](std::intmax_t n) {
+        char digits[20];
+        auto p = digits + sizeof digits;
+        do { *--p = static_cast<char>('0' + n % 10); } while (n /= 10);
+        put({p, static_cast<std::size_t>(digits + sizeof digits - p)});
+    };
+    put("%?");
+    if constexpr (std::ratio_equal_v<Period, std::nano>) put("ns");
+    else if constexpr (std::ratio_equal_v<Period, std::micro>) put("us");
+    else if constexpr (std::ratio_equal_v<Period, std::milli>) put("ms");
+    else if constexpr (std::ratio_equal_v<Period, std::ratio<1>>) put("s");
+    else if constexpr (std::ratio_equal_v<Period, std::ratio<60>>) put("min");
+    else if constexpr (std::ratio_equal_v<Period, std::ratio<3600>>) put("h");
+    else if constexpr (std::ratio_equal_v<Period, std::ratio<86400>>) put("d");
+    else {
+        put("[");
+        put_number(Period::num);
+        if (Period::den != 1) put("/"), put_number(Period::den);
+        put("]s");
+    }
+    return fmt;
+}();
+
+// The fraction digits of a time with a tick of `Period`: none, or enough for
+// milliseconds, microseconds or nanoseconds.
+template <typename Period>
+inline constexpr int fraction_digits = Period::den == 1 ? 0
+        : Period::den <= 1'000 ? 3 : Period::den <= 1'000'000 ? 6 : 9;
+
+template <typename Period>
+inline constexpr auto time_fmt = [] {
+    constexpr std::string_view fractions[] = {"", ".%03u", ".%06u", ".%09u"};
+    constexpr auto fraction = fractions[fraction_digits<Period> / 3];
+    constexpr std::string_view date = "%04d-%02u-%02uT%02u:%02u:%02u";
+    auto fmt = literal<date.size() + fraction.size() + 2>{};
+    auto out = fmt.data;
+    for (auto const ch : date) *out++ = ch;
+    for (auto const ch : fraction) *out++ = ch;
+    *out = 'Z';
+    return fmt;
+}();
+
+struct civil_date {
+    int year;
+    unsigned month;
+    unsigned day;
+};
+
+// The proleptic Gregorian date of a count of days since 1970-01-01 (Howard
+// Hinnant's `civil_from_days`), with no tables and no time zone.
+constexpr civil_date civil_from_days(std::int64_t z) noexcept {
+    z += 719468;
+    auto const era = (z >= 0 ? z : z - 146096) / 146097;
+    auto const doe = static_cast<unsigned>(z - era * 146097);
+    auto const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    auto const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    auto const mp = (5 * doy + 2) / 153;
+    auto const day = doy - (153 * mp + 2) / 5 + 1;
+    auto const month = mp < 10 ? mp + 3 : mp - 9;
+    auto const year = static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2);
+    return {static_cast<int>(year), month, day};
+}
+
+} // namespace chrono
+
+// Durations are printed as their count and unit, such as "250ms".
+template <typename Rep, typename Period>
+struct traits<std::chrono::duration<Rep, Period>> {
+    static constexpr auto fmt = chrono::duration_fmt<Period>;
+    static constexpr auto fwd_args(
+            std::chrono::duration<Rep, Period> const& d) noexcept {
+        return std::tuple{d.count()};
+    }
+};
+
+// System clock times are printed in UTC, in ISO 8601 form, with the fraction
+// of a second that their duration can hold: "2024-02-29T13:05:07.042Z".
+template <typename Duration>
+    requires std::is_integral_v<typename Duration::rep>
+struct traits<std::chrono::time_point<std::chrono::system_clock, Duration>> {
+    static constexpr auto fmt = chrono::time_fmt<typename Duration::period>;
+    static constexpr auto fwd_args(std::chrono::time_point<
+            std::chrono::system_clock, Duration> const& t) noexcept {
+        using namespace std::chrono;
+        auto const since = t.time_since_epoch();
+        auto const days = floor<std::chrono::days>(since);
+        auto const date = chrono::civil_from_days(days.count());
+        auto const time = static_cast<unsigned>(
+                floor<seconds>(since - days).count());
+        auto const fields = std::tuple{date.year, date.month, date.day,
+                time / 3600, time / 60 % 60, time % 60};
+        constexpr auto digits = chrono::fraction_digits<typename Duration::period>;
+        if constexpr (digits == 0) {
+            return fields;
+        } else {
+            using unit = std::conditional_t<digits == 3, milliseconds,
+                    std::conditional_t<digits == 6, microseconds, nanoseconds>>;
+            auto const fraction = duration_cast<unit>(since - floor<seconds>(since));
+            return std::tuple_cat(fields,
+                    std::tuple{static_cast<unsigned>(fraction.count())});
+        }
+    }
+};
+#endif // !ROSTD_PRINTX_FREESTANDING
+
+// The name of a type as a null-terminated string.
+template <typename Type>
+inline constexpr auto type_name_literal = [] {
+    constexpr auto name = type_name<Type>();
+    auto buffer = literal<name.size() + 1>{};
+    for (std::size_t i = 0; i < name.size(); ++i) buffer.data[i] = name[i];
+    return buffer;
+}();
+
+} // namespace detail
+
+/**
+ * The registry lists format strings known to the program. When
+ * `ROSTD_PRINTX_REGISTRY` is defined (consistently, for every translation
+ * unit), every instantiation of `build_fmt` contributes a constant-initialized
+ * `format_record`, linked into the list during static initialization. It can
+ * be enumerated from `main` onwards, and costs nothing per call.
+ */
+namespace registry {
+
+struct format_record {
+    std::uint64_t id;              // `format_id<Fmt, Args...>()`
+    char const* format;            // as written in the source
+    char const* transformed;       // as passed to the underlying function
+    char const* const* arg_types;  // `arg_count` type names
+    std::size_t arg_count;
+    char const* file;              // source location, when the front end
+    unsigned line;                 //   provides it (otherwise null and 0)
+    format_record const* next;
+};
+
+// Head of the list of all records.
+inline std::atomic<format_record const*> records{nullptr};
+
+inline bool link(format_record& record) noexcept {
+    record.next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(record.next, &record,
+            std::memory_order_release, std::memory_order_relaxed)) {}
+    return true;
+}
+
+// The first record in the list; follow with `format_record::next`.
+inline format_record const* first() noexcept {
+    return records.load(std::memory_order_acquire);
+}
+
+// Finds a record by its identifier, or returns null.
+inline format_record const* find(std::uint64_t const id) noexcept {
+    auto record = first();
+    while (record && record->id != id) record = record->next;
+    return record;
+}
+
+} // namespace registry
+
+namespace detail {
+
 template <literal Fmt, typename... Args>
-consteval auto build_fmt() noexcept {
-    using namespace printx::detail;
+struct registration {
+    static constexpr char const* arg_types[sizeof...(Args) + 1] = {
+            type_name_literal<Args>.data..., nullptr};
+    static constinit registry::format_record record;
+    static inline bool const linked = registry::link(record);
+};
+
+} // namespace detail
+
+namespace detail {
+
+template <literal Fmt, typename... Args>
+consteval auto transform_fmt(unsigned const conversions = all_conversions)
+        noexcept {
     auto buffer = literal<count_size<Args...>(Fmt.data) + 1>{};
     auto src = Fmt.data;
-    auto const st = appending_transformer{buffer.data}.transform<Args...>(src);
+    auto const st = appending_transformer{buffer.data, conversions}
+            .transform<Args...>(src);
     check_error(st);
     return buffer;
 }
 
+template <typename Text>
+constexpr char const* text_of(Text const& text) noexcept {
+    if constexpr (requires { text.data; }) return text.data;
+    else return text;
+}
+
+// The sub-format of a type, as a literal.
+template <typename Arg>
+inline constexpr auto sub_format = [] {
+    constexpr auto text = std::string_view{text_of(traits<Arg>::fmt)};
+    auto buffer = literal<text.size() + 1>{};
+    for (std::size_t i = 0; i < text.size(); ++i) buffer.data[i] = text[i];
+    return buffer;
+}();
+
+template <literal Fmt, typename Members> struct transformed_members;
+
+template <literal Fmt, typename... Members>
+struct transformed_members<Fmt, std::tuple<Members...>> {
+    static constexpr auto fmt = transform_fmt<Fmt, Members...>();
+};
+
+// Forwarding a copy of a string member would leave a dangling pointer.
+template <typename Members>
+inline constexpr bool copies_strings = false;
+
+template <typename... Members>
+inline constexpr bool copies_strings<std::tuple<Members...>> =
+        ((!std::is_reference_v<Members> && requires(Members m) { m.c_str(); })
+         || ...);
+
+template <typename Arg>
+constexpr char const* spec_of() noexcept {
+    if constexpr (concepts::composite<Arg>) {
+        static_assert(!copies_strings<members_of<Arg>>,
+                "fwd_args must refer to string members (use std::tie)");
+        return transformed_members<sub_format<Arg>, members_of<Arg>>::fmt.data;
+    } else {
+        return traits<Arg>::spec;
+    }
+}
+
+// How many values of type `Leaf` are forwarded for `Arg`, members and all.
+template <typename Leaf, typename Arg>
+consteval std::size_t forwarded_count() noexcept {
+    if constexpr (concepts::composite<Arg>) {
+        return []<typename... Members>(std::tuple<Members...>*) {
+            return (std::size_t{0} + ...
+                    + forwarded_count<Leaf, std::remove_cvref_t<Members>>());
+        }(static_cast<members_of<Arg>*>(nullptr));
+    } else {
+        return std::same_as<Leaf, Arg>;
+    }
+}
+
+// Whether the values of `Arg` (or of its members) that traits<> render fit
+// the ring of slots that `fwd_args` renders each type into, given all of the
+// arguments of a call.
+template <typename Arg, typename... Args>
+consteval bool fits_render_slots() noexcept {
+    if constexpr (concepts::composite<Arg>) {
+        return []<typename... Members>(std::tuple<Members...>*) {
+            return (fits_render_slots<std::remove_cvref_t<Members>, Args...>()
+                    && ...);
+        }(static_cast<members_of<Arg>*>(nullptr));
+    } else if constexpr (concepts::renders<Arg>) {
+        return (std::size_t{0} + ... + forwarded_count<Arg, Args>())
+                <= render_slots;
+    } else {
+        return true;
+    }
+}
+
+// As `build_fmt`, for an output engine that implements only `Conversions`.
+template <literal Fmt, unsigned Conversions, typename... Args>
+consteval auto build_fmt_for() noexcept {
+#if defined(ROSTD_PRINTX_REGISTRY)
+    (void)&registration<Fmt, std::remove_cvref_t<Args>...>::linked;
+#endif
+    return transform_fmt<Fmt, Args...>(Conversions);
+}
+
+} // namespace detail
+
+template <literal Fmt, typename... Args>
+consteval auto build_fmt() noexcept {
+    return detail::build_fmt_for<Fmt, detail::all_conversions, Args...>();
+}
+
 template <typename Function, typename... Args>
-decltype(auto) invoke(Function const& call, Args const&... args) {
+constexpr decltype(auto) invoke(Function const& call, Args const&... args) {
+    static_assert((detail::fits_render_slots<Args, Args...>() && ...),
+            "too many rendered values of one type for a call (see render_slots)");
     if constexpr (sizeof...(args) == 0) return call();
     else return std::apply(call, std::tuple_cat(detail::fwd_args(args)...));
 }
 
+// Identifies a format and argument type combination. The identifier depends
+// only on the format string and the names of the argument types, so it is
+// stable across builds with the same compiler.
+template <literal Fmt, typename... Args>
+consteval std::uint64_t format_id() noexcept {
+    auto hash = detail::fnv1a(Fmt.data);
+    ((hash = detail::fnv1a(detail::type_name<std::remove_cvref_t<Args>>(),
+            hash)), ...);
+    return hash;
+}
+
+namespace detail {
+
+// The transformed format string, as a variable.
+template <literal Fmt, typename... Args>
+inline constexpr auto transformed_fmt = transform_fmt<Fmt, Args...>(
+        all_conversions | range_conversions | escape_conversions);
+
+template <literal Fmt, typename... Args>
+constinit registry::format_record registration<Fmt, Args...>::record = {
+    format_id<Fmt, Args...>(), Fmt.data, transformed_fmt<Fmt, Args...>.data,
+    arg_types, sizeof...(Args), nullptr, 0u, nullptr
+};
+
+} // namespace detail
+
+#if defined(ROSTD_PRINTX_INSTRUMENT)
+/**
+ * When `ROSTD_PRINTX_INSTRUMENT` is defined (consistently, for every
+ * translation unit), each `rostd::printf`-family instantiation keeps a
+ * `call_site` record of how often it is called, how many bytes it produces,
+ * and how long it takes. Records are constant-initialized and link themselves
+ * into a global list on their first call.
+ */
+namespace instrument {
+
+class call_site {
+public:
+    // Formatting times are kept in a log-linear histogram: exact below 8ns,
+    // then 4 buckets per power of two, up to 2^40ns.
+    static constexpr std::size_t buckets = 8 + 37 * 4;
+
+    constexpr call_site(std::uint64_t id, char const* format,
+            char const* transformed) noexcept
+        : id{id}, format{format}, transformed{transformed} {}
+    call_site(call_site const&) = delete;
+    call_site& operator=(call_site const&) = delete;
+
+    std::uint64_t const id;
+    char const* const format;      // as written in the source
+    char const* const transformed; // as passed to the underlying function
+
+    std::uint64_t calls() const noexcept { return load(calls_); }
+    std::uint64_t bytes() const noexcept { return load(bytes_); }
+    std::uint64_t nanoseconds() const noexcept { return load(nanoseconds_); }
+    std::uint64_t count(std::size_t bucket) const noexcept
+            { return load(histogram[bucket]); }
+
+    // The smallest duration (in nanoseconds) that falls in a bucket.
+    static constexpr std::uint64_t lower_bound(std::size_t const bucket) {
+        if (bucket < 8) return bucket;
+        auto const exponent = (bucket - 8) / 4 + 3;
+        return (4 + (bucket - 8) % 4) << (exponent - 2);
+    }
+
+    // The lower bound of the bucket holding the given quantile [0, 1].
+    std::uint64_t quantile(double q) const noexcept;
+
+    call_site const* next() const noexcept { return next_; }
+
+    void record(std::uint64_t const ns, int const result) noexcept {
+        if (!linked.load(std::memory_order_relaxed)) [[unlikely]] link();
+        calls_.fetch_add(1, std::memory_order_relaxed);
+        if (result > 0)
+            bytes_.fetch_add(result, std::memory_order_relaxed);
+        nanoseconds_.fetch_add(ns, std::memory_order_relaxed);
+        histogram[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::size_t bucket(std::uint64_t const ns) noexcept {
+        if (ns < 8) return ns;
+        auto const exponent = std::bit_width(ns) - 1;
+        auto const index = 8 + (exponent - 3) * 4 + ((ns >> (exponent - 2)) & 3);
+        return index < buckets ? index : buckets - 1;
+    }
+
+    static std::uint64_t load(std::atomic<std::uint64_t> const& v) noexcept
+            { return v.load(std::memory_order_relaxed); }
+
+    void link() noexcept;
+
+    std::atomic<std::uint64_t> calls_{0};
+    std::atomic<std::uint64_t> bytes_{0};
+    std::atomic<std::uint64_t> nanoseconds_{0};
+    std::atomic<std::uint64_t> histogram[buckets] = {};
+    std::atomic<bool> linked{false};
+    call_site const* next_ = nullptr;
+};
+
+// Head of the list of every call site that has been called at least once.
+inline std::atomic<call_site const*> call_sites{nullptr};
+
+inline void call_site::link() noexcept {
+    if (linked.exchange(true, std::memory_order_relaxed)) return;
+    next_ = call_sites.load(std::memory_order_relaxed);
+    while (!call_sites.compare_exchange_weak(next_, this,
+            std::memory_order_release, std::memory_order_relaxed)) {}
+}
+
+inline std::uint64_t call_site::quantile(double const q) const noexcept {
+    auto const total = calls();
+    auto seen = std::uint64_t{};
+    for (std::size_t i = 0; i < buckets; ++i) {
+        seen += count(i);
+        if (total != 0 && seen >= q * total) return lower_bound(i);
+    }
+    return 0;
+}
+
+// The first record in the list; follow with `call_site::next()`.
+inline call_site const* first() noexcept {
+    return call_sites.load(std::memory_order_acquire);
+}
+
+// Writes a table of all records to `stream`, costliest (by total time) first.
+inline void dump(std::FILE* const stream) noexcept {
+    auto sites = std::vector<call_site const*>{};
+    for (auto site = first(); site; site = site->next()) sites.push_back(site);
+    std::sort(sites.begin(), sites.end(), [](auto const* a, auto const* b) {
+        return a->nanoseconds() > b->nanoseconds();
+    });
+    auto print = [&]<literal Fmt, typename... Args>(Args const&... args) {
+        invoke([&](auto const&... args) {
+            static constexpr auto fmt = build_fmt<Fmt, Args...>();
+            std::fprintf(stream, fmt.data, args...);
+        }, args...);
+    };
+    print.template operator()<"%-16s %12s %14s %14s %10s %10s  %s\n">(
+            "id", "calls", "bytes", "total_ns", "p50_ns", "p99_ns", "format");
+    for (auto const* site : sites) {
+        print.template operator()<"%016x %12? %14? %14? %10? %10?  %?\n">(
+                site->id, site->calls(), site->bytes(), site->nanoseconds(),
+                site->quantile(0.5), site->quantile(0.99), site->format);
+    }
+}
+
+} // namespace instrument
+#endif
+
+namespace detail {
+
+// Calls `call` (a printf-family invocation), recording its result and timing
+// against the call site for `Fmt` when instrumentation is enabled.
+template <literal Fmt, typename... Args, typename Function>
+[[gnu::always_inline]] inline int instrumented(Function const& call) noexcept {
+#if defined(ROSTD_PRINTX_INSTRUMENT)
+    static constinit auto site = instrument::call_site{
+            format_id<Fmt, Args...>(), Fmt.data,
+            transformed_fmt<Fmt, Args...>.data};
+    using clock = std::chrono::steady_clock;
+    auto const start = clock::now();
+    auto const result = call();
+    site.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            clock::now() - start).count(), result);
+    return result;
+#else
+    return call();
+#endif
+}
+
+} // namespace detail
+
+namespace detail {
+
+struct positions {
+    status st = status::correct;
+    bool positional = false; // any conversion has an argument position
+    std::size_t size = 0;    // of the sequential format
+    std::size_t count = 0;   // of arguments consumed
+    std::size_t highest = 0; // argument position
+};
+
+// Rewrites a format with POSIX argument positions (`%n$` and `*m$`) into one
+// that consumes its arguments in order. The sequential format is written to
+// `out`, and the zero-based argument consumed at each step to `order`, unless
+// they are null. A format without positions is not rewritten.
+constexpr positions sequence_positions(char const* src, char* const out,
+        std::size_t* const order) noexcept {
+    auto result = positions{};
+    auto sequential = false;
+    auto const put = [&](char const ch) {
+        if (out) out[result.size] = ch;
+        ++result.size;
+    };
+    auto const position = [&](std::size_t& n) { // reads "n$", if present
+        auto p = src;
+        for (n = 0; *p >= '0' && *p <= '9'; ++p)
+            n = n * 10 + static_cast<std::size_t>(*p - '0');
+        if (p == src || *p != '$') return false;
+        src = p + 1;
+        return true;
+    };
+    auto const consume = [&](std::size_t const n, bool const positioned) {
+        if (!positioned) {
+            sequential = true;
+            return;
+        }
+        result.positional = true;
+        if (n == 0) {
+            result.st = status::format_invalid_position;
+            return;
+        }
+        if (order) order[result.count] = n - 1;
+        ++result.count;
+        if (n > result.highest) result.highest = n;
+    };
+    while (*src) {
+        if (*src != '%') {
+            put(*src++);
+            continue;
+        }
+        put(*src++);
+        if (*src == '%') {
+            put(*src++);
+            continue;
+        }
+        auto value = std::size_t{};
+        auto const positioned = position(value);
+        if (*src == '{') // an escaping
+            while (*src && (put(*src++), src[-1] != '}')) {}
+        auto digits = src;
+        while (*digits >= '0' && *digits <= '9') ++digits;
+        if (*digits == '[') { // a range's group size and separator
+            while (src != digits) put(*src++);
+            while (*src && (put(*src++), src[-1] != ']')) {}
+        }
+        while (*src && std::string_view{"-+ #0"}.find(*src)
+                != std::string_view::npos)
+            put(*src++);
+        for (auto const precision : {false, true}) {
+            if (precision) {
+                if (*src != '.') break;
+                put(*src++);
+            }
+            if (*src == '*') {
+                put(*src++);
+                auto n = std::size_t{};
+                auto const positioned = position(n);
+                consume(n, positioned);
+            } else {
+                while (*src >= '0' && *src <= '9') put(*src++);
+            }
+        }
+        while (*src && std::string_view{"csdiuoxXfFeEgGaApn?"}.find(*src)
+                == std::string_view::npos)
+            put(*src++);
+        if (*src) put(*src++);
+        consume(value, positioned);
+    }
+    if (result.positional && sequential && result.st == status::correct)
+        result.st = status::format_mixed_positions;
+    if (out) out[result.size] = '\0';
+    return result;
+}
+
+template <literal Fmt>
+inline constexpr auto format_positions = sequence_positions(Fmt.data, nullptr,
+        nullptr);
+
+// Whether a format gives argument positions, and must be made sequential.
+template <literal Fmt>
+inline constexpr bool positional = format_positions<Fmt>.positional;
+
+template <literal Fmt>
+inline constexpr auto sequential_fmt = [] {
+    check_error(format_positions<Fmt>.st);
+    auto buffer = literal<format_positions<Fmt>.size + 1>{};
+    sequence_positions(Fmt.data, buffer.data, nullptr);
+    return buffer;
+}();
+
+// The argument consumed by each step of the sequential format.
+template <literal Fmt>
+inline constexpr auto argument_order = [] {
+    auto order = std::array<std::size_t, format_positions<Fmt>.count>{};
+    sequence_positions(Fmt.data, nullptr, order.data());
+    return order;
+}();
+
+// Every one of `Count` arguments must be used, as with a sequential format.
+template <literal Fmt, std::size_t Count>
+consteval bool check_positions() noexcept {
+    check_error(format_positions<Fmt>.st);
+    if (format_positions<Fmt>.highest > Count)
+        check_error(status::format_not_enough_args);
+    for (std::size_t i = 0; i < Count; ++i) {
+        auto used = false;
+        for (auto const n : argument_order<Fmt>) used = used || n == i;
+        if (!used) check_error(status::format_too_many_args);
+    }
+    return true;
+}
+
+// Calls `call.template operator()<Seq>(...)`, where `Seq` is the sequential
+// form of a positional format, with the arguments in the order it consumes
+// them. The reordering is fixed at compile time, so the underlying function
+// never sees an argument position.
+template <literal Fmt, typename Call, typename... Args>
+constexpr decltype(auto) with_positions(Call const& call,
+        Args const&... args) {
+    static_assert(check_positions<Fmt, sizeof...(Args)>());
+    auto const refs = std::tuple<Args const&...>{args...};
+    return [&]<std::size_t... I>(std::index_sequence<I...>) -> decltype(auto) {
+        return call.template operator()<sequential_fmt<Fmt>>(
+                std::get<argument_order<Fmt>[I]>(refs)...);
+    }(std::make_index_sequence<argument_order<Fmt>.size()>{});
+}
+
+struct lowered {
+    status st;
+    std::size_t size;
+};
+
+// Lowers a format in `std::format` style to printf style, writing it to `out`
+// unless that is null. Replacement fields become conversions:
+//
+//     {[index]} or {[index]:[<|>][+| |-][#][0][width][.precision][type]}
+//
+// where `type` is one of `d o x X e E f F g G a A s c p`, and is deduced (as
+// with `%?`) when it is omitted. Alignment is to the right unless '<' is
+// given, as with printf. An index becomes an argument position (`{0}` is
+// `%1$?`). Nested fields, fill characters, centering and locale-specific
+// formatting have no printf equivalent.
+consteval lowered lower_braces(char const* src, char* const out) noexcept {
+    auto n = std::size_t{};
+    auto const put = [&](char const ch) {
+        if (out) out[n] = ch;
+        ++n;
+    };
+    auto const digits = [&] {
+        while (*src >= '0' && *src <= '9') put(*src++);
+    };
+    while (*src) {
+        auto const ch = *src++;
+        if (ch == '%') {
+            put('%');
+            put('%');
+        } else if (ch == '}') {
+            if (*src++ != '}') return {status::braces_unmatched, n};
+            put('}');
+        } else if (ch != '{') {
+            put(ch);
+        } else if (*src == '{') {
+            put(*src++);
+        } else {
+            put('%');
+            if (*src >= '0' && *src <= '9') { // argument index, from 0
+                auto index = std::size_t{};
+                while (*src >= '0' && *src <= '9')
+                    index = index * 10 + static_cast<std::size_t>(*src++ - '0');
+                auto digits = std::size_t{1};
+                for (auto n = index + 1; n >= 10; n /= 10) digits *= 10;
+                for (auto n = index + 1; digits; digits /= 10)
+                    put(static_cast<char>('0' + n / digits % 10));
+                put('$');
+            }
+            if (*src == ':') {
+                if (*++src && (src[1] == '<' || src[1] == '>' || src[1] == '^'))
+                    return {status::braces_not_supported, n}; // fill
+                if (*src == '^') return {status::braces_not_supported, n};
+                if (*src == '<') put('-'), ++src;
+                else if (*src == '>') ++src;
+                if (*src == '+' || *src == ' ') put(*src++);
+                else if (*src == '-') ++src;
+                if (*src == '#') put(*src++);
+                if (*src == '0') put(*src++);
+                digits();
+                if (*src == '.') {
+                    put(*src++);
+                    if (*src < '0' || *src > '9')
+                        return {status::braces_not_supported, n};
+                    digits();
+                }
+                if (*src && std::string_view{"doxXeEfFgGaAscp"}.find(*src)
+                        != std::string_view::npos)
+                    put(*src++);
+                else
+                    put('?');
+            } else {
+                put('?');
+            }
+            if (*src != '}') {
+                return {*src ? status::braces_not_supported
+                             : status::braces_unmatched, n};
+            }
+            ++src;
+        }
+    }
+    if (out) out[n] = '\0';
+    return {status::correct, n};
+}
+
+template <literal Fmt>
+consteval auto lower_braces() noexcept {
+    constexpr auto result = lower_braces(Fmt.data, nullptr);
+    check_error(result.st);
+    auto buffer = literal<result.size + 1>{};
+    lower_braces(Fmt.data, buffer.data);
+    return buffer;
+}
+
+} // namespace detail
 } // namespace printx
 
+/**
+ * A format written in `std::format` style, lowered to a printf format at
+ * compile time. It is used wherever a printx format is, and the result is
+ * exactly what the equivalent printf format would give, in code size as well:
+ *
+ *     rostd::printf<rostd::braces<"id={} t={:.3}\n">>(id, t);
+ *
+ * Each `{}` is `%?`; see `printx::detail::lower_braces` for the supported
+ * specifications. Values print as they do with `%?` (so `bool` prints as a
+ * number), and the arguments are checked by the same rules as any printx call.
+ */
+template <printx::literal Fmt>
+inline constexpr auto braces = printx::detail::lower_braces<Fmt>();
+
+#if !defined(ROSTD_PRINTX_FREESTANDING)
+namespace printx::detail {
+
+// Writes `size` characters of constant text with the result that a
+// `printf`-family call would give.
+[[gnu::always_inline]] inline int write_text(std::FILE* const stream,
+        char const* const text, std::size_t const size) noexcept {
+    return std::fwrite(text, 1, size, stream) == size
+            ? static_cast<int>(size) : -1;
+}
+
+// The offset of the text that follows the last conversion of a transformed
+// format (zero if there are no conversions).
+consteval std::size_t tail_offset(char const* const fmt) noexcept {
+    auto offset = std::size_t{};
+    for (std::size_t i = 0; fmt[i]; ++i) {
+        if (fmt[i] != '%' || fmt[++i] == '%') continue;
+        while (std::string_view{"diouxXcspnfFeEgGaA"}.find(fmt[i])
+                == std::string_view::npos)
+            ++i;
+        offset = i + 1;
+    }
+    return offset;
+}
+
+// A transformed format up to the text after its last conversion.
+template <literal Fmt>
+inline constexpr auto format_head = [] {
+    auto head = literal<tail_offset(Fmt.data) + 1>{};
+    for (std::size_t i = 0; i + 1 < sizeof head.data; ++i)
+        head.data[i] = Fmt.data[i];
+    return head;
+}();
+
+// The text after the last conversion, as it will be printed ("%%" as '%').
+template <literal Fmt>
+inline constexpr auto format_tail = [] {
+    constexpr auto size = [] {
+        auto n = std::size_t{};
+        for (auto p = Fmt.data + tail_offset(Fmt.data); *p; ++p, ++n)
+            if (*p == '%') ++p;
+        return n;
+    }();
+    auto tail = literal<size + 1>{};
+    auto out = tail.data;
+    for (auto p = Fmt.data + tail_offset(Fmt.data); *p; *out++ = *p++)
+        if (*p == '%') ++p;
+    return tail;
+}();
+
+// Whether a format has range conversions or escaping, which `printf` cannot
+// print: such a format is printed by the native engine instead.
+template <literal Fmt>
+inline constexpr bool needs_native = [] {
+    for (auto p = Fmt.data; *p; ++p) {
+        if (*p != '%' || *++p == '%') continue;
+        while ((*p >= '0' && *p <= '9') || *p == '$') ++p;
+        if (*p == '[' || *p == '{') return true;
+        if (!*p) break;
+    }
+    return false;
+}();
+
+namespace native {
+
+// Prints with the native engine (defined with it).
+template <literal Fmt, typename... Args>
+int print_native(std::FILE* stream, Args const&... args) noexcept;
+
+template <literal Fmt, typename... Args>
+int print_native(char* s, std::size_t n, Args const&... args) noexcept;
+
+} // namespace native
+
+// Formats of at least this many characters after their last conversion are
+// split, so that the tail is written directly instead of being parsed.
+inline constexpr std::size_t long_tail = 64;
+
+// Prints a transformed format to `stream`, where `print` is the
+// `printf`-family call for a given format. A format without conversions is
+// written directly; so is a long tail, with the stream locked so that the
+// two parts cannot be separated by another thread's output.
+template <literal Fmt, typename Print>
+[[gnu::always_inline]] inline int print_to(std::FILE* const stream,
+        Print const& print) noexcept {
+    using tail = std::integral_constant<std::size_t,
+            sizeof format_tail<Fmt>.data - 1>;
+    if constexpr (tail_offset(Fmt.data) == 0) {
+        return write_text(stream, format_tail<Fmt>.data, tail::value);
+    } else if constexpr (tail::value < long_tail) {
+        return print(Fmt.data);
+    } else {
+#if defined(_WIN32)
+        _lock_file(stream);
+#else
+        flockfile(stream);
+#endif
+        auto result = print(format_head<Fmt>.data);
+        if (result >= 0) {
+            auto const written = write_text(stream, format_tail<Fmt>.data,
+                    tail::value);
+            result = written < 0 ? -1 : result + written;
+        }
+#if defined(_WIN32)
+        _unlock_file(stream);
+#else
+        funlockfile(stream);
+#endif
+        return result;
+    }
+}
+
+} // namespace printx::detail
+
 #if defined(__GNUC__) || defined(__clang__)
     // These functions send what appear to the compiler to be non-literals to
     // `printf`-family calls. Disable these warnings in order to compile
@@ -442,48 +1820,114 @@ decltype(auto) invoke(Function const& call, Args const&... args) {
     #pragma GCC diagnostic ignored "-Wformat-security"
 #endif
 
+// A format with argument positions is made sequential at compile time, and
+// its arguments reordered to match; see `printx::detail::with_positions`. A
+// format with range conversions or escaping is printed by the native engine.
 template <printx::literal Fmt, typename... Args>
 [[gnu::always_inline, gnu::flatten]] inline
 int printf(Args const&... args) noexcept {
-    return printx::invoke([](auto const&... args) {
-            static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
-            return std::printf(fmt.data, args...);
-        }, args...);
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::printf<Seq>(args...);
+                }, args...);
+    } else if constexpr (printx::detail::needs_native<Fmt>) {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::detail::native::print_native<Fmt>(stdout, args...);
+        });
+    } else {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::invoke([](auto const&... args) {
+                    static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
+                    return printx::detail::print_to<fmt>(stdout,
+                            [&](char const* const format) {
+                                return std::printf(format, args...);
+                            });
+                }, args...);
+        });
+    }
 }
 
 template <printx::literal Fmt, typename Stream, typename... Args>
 [[gnu::always_inline, gnu::flatten]] inline
 int fprintf(Stream const& stream, Args const&... args) noexcept {
-    return printx::invoke([&](auto const&... args) {
-            static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
-            return std::fprintf(stream, fmt.data, args...);
-        }, args...);
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::fprintf<Seq>(stream, args...);
+                }, args...);
+    } else if constexpr (printx::detail::needs_native<Fmt>) {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::detail::native::print_native<Fmt>(stream, args...);
+        });
+    } else {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::invoke([&](auto const&... args) {
+                    static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
+                    return printx::detail::print_to<fmt>(stream,
+                            [&](char const* const format) {
+                                return std::fprintf(stream, format, args...);
+                            });
+                }, args...);
+        });
+    }
 }
 
 template <printx::literal Fmt, typename... Args>
 [[gnu::always_inline, gnu::flatten]] inline
 int snprintf(char* s, std::size_t n, Args const&... args) noexcept {
-    return printx::invoke([&](auto const&... args) {
-            static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
-            return std::snprintf(s, n, fmt.data, args...);
-        }, args...);
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::snprintf<Seq>(s, n, args...);
+                }, args...);
+    } else if constexpr (printx::detail::needs_native<Fmt>) {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::detail::native::print_native<Fmt>(s, n, args...);
+        });
+    } else {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::invoke([&](auto const&... args) {
+                    static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
+                    return std::snprintf(s, n, fmt.data, args...);
+                }, args...);
+        });
+    }
 }
 
 template <printx::literal Fmt, typename Buffer, typename... Args>
     requires requires(Buffer b) { std::data(b); std::size(b); }
 [[gnu::always_inline, gnu::flatten]] inline
 int sprintf(Buffer&& buffer, Args const&... args) noexcept {
-    return printx::invoke([&](auto const&... args) {
-            static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
-            return std::snprintf(std::data(buffer), std::size(buffer),
-                    fmt.data, args...);
-        }, args...);
+    if constexpr (printx::detail::positional<Fmt>) {
+        return printx::detail::with_positions<Fmt>(
+                [&]<printx::literal Seq>(auto const&... args) {
+                    return rostd::sprintf<Seq>(buffer, args...);
+                }, args...);
+    } else if constexpr (printx::detail::needs_native<Fmt>) {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::detail::native::print_native<Fmt>(
+                    std::data(buffer), std::size(buffer), args...);
+        });
+    } else {
+        return printx::detail::instrumented<Fmt, Args...>([&] {
+            return printx::invoke([&](auto const&... args) {
+                    static constexpr auto fmt = printx::build_fmt<Fmt, Args...>();
+                    return std::snprintf(std::data(buffer), std::size(buffer),
+                            fmt.data, args...);
+                }, args...);
+        });
+    }
 }
 
 #if defined(__GNUC__) || defined(__clang__)
     #pragma GCC diagnostic pop
 #endif
+#endif // !ROSTD_PRINTX_FREESTANDING
 
 } // namespace rostd
 
+// The native engine, which formats constant arguments at compile time.
+#include <rostd/printx/engine.hpp>
+
 #endif // ROSTD_PRINTX_HPP
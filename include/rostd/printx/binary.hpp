@@ -0,0 +1,547 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_BINARY_HPP
+#define ROSTD_PRINTX_BINARY_HPP
+
+#include <rostd/printx/packed.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rostd {
+namespace printx {
+
+class binary_decoder;
+
+/**
+ * Binary log records refer to their format by identifier. Each format that is
+ * written to a binary log has a `binary_format` entry in the catalog, which is
+ * constant-initialized and linked during static initialization, so that a
+ * reader in the same program can decode records written by any other
+ * instance of it.
+ */
+struct binary_format {
+    std::uint64_t id;            // `format_id<Fmt, Args...>()`
+    char const* format;          // as written in the source
+    // Decodes the arguments of one record and formats them into `out`.
+    bool (*decode)(binary_decoder&, std::string& out);
+    // Formats arguments captured by `packed_args` into `out`.
+    bool (*format_packed)(std::byte const*, std::string& out);
+    std::uint32_t index;         // dense index, assigned when linked
+    binary_format const* next;
+};
+
+namespace detail {
+namespace binary {
+
+inline constexpr std::byte magic[] = {std::byte{'P'}, std::byte{'X'},
+        std::byte{'B'}, std::byte{1}}; // the last byte is the version
+inline constexpr std::size_t header_size = sizeof magic + 1; // + flags
+enum : std::uint8_t { interned_strings = 1 };
+
+inline std::atomic<binary_format const*> formats{nullptr};
+inline std::atomic<std::uint32_t> format_count{0};
+
+inline bool link(binary_format& format) noexcept {
+    format.index = format_count.fetch_add(1, std::memory_order_relaxed);
+    format.next = formats.load(std::memory_order_relaxed);
+    while (!formats.compare_exchange_weak(format.next, &format,
+            std::memory_order_release, std::memory_order_relaxed)) {}
+    return true;
+}
+
+constexpr std::uint64_t zigzag(std::int64_t const v) noexcept {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+constexpr std::int64_t unzigzag(std::uint64_t const v) noexcept {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+} // namespace binary
+} // namespace detail
+
+// The first entry in the catalog; follow with `binary_format::next`.
+inline binary_format const* first_binary_format() noexcept {
+    return detail::binary::formats.load(std::memory_order_acquire);
+}
+
+// Finds a catalog entry by its identifier, or returns null.
+inline binary_format const* find_binary_format(std::uint64_t const id) noexcept {
+    auto format = first_binary_format();
+    while (format && format->id != id) format = format->next;
+    return format;
+}
+
+/**
+ * Appends compactly encoded values to a byte vector:
+ *
+ * - unsigned integers, pointers: LEB128 varint
+ * - signed integers: zigzag, then varint
+ * - floating point and other trivially copyable values: raw bytes
+ * - strings: varint header `h`, where `h == 0` is a null pointer, an even
+ *   `h` is followed by `h / 2 - 1` bytes of string contents, and an odd `h`
+ *   refers to entry `h / 2` of the interned string table
+ *
+ * When interning is enabled, every string written out in full is added to
+ * the table (up to `intern_limit` entries) on both the encoding and the
+ * decoding side, and repeats are written as references.
+ */
+class binary_encoder {
+public:
+    static constexpr std::size_t intern_limit = 4096;
+
+    explicit binary_encoder(std::vector<std::byte>& out,
+            bool const intern = false) noexcept
+        : out{&out}, intern{intern} {}
+
+    // The interned strings are referred to by the table, so an encoder can
+    // be moved (to write to another vector) but not copied.
+    binary_encoder(binary_encoder const&) = delete;
+    binary_encoder& operator=(binary_encoder const&) = delete;
+    binary_encoder(binary_encoder&&) = default;
+    binary_encoder& operator=(binary_encoder&&) = default;
+
+    // Writes to `to` from now on.
+    void retarget(std::vector<std::byte>& to) noexcept { out = &to; }
+
+    void varint(std::uint64_t v) {
+        while (v >= 0x80) {
+            out->push_back(static_cast<std::byte>(v | 0x80));
+            v >>= 7;
+        }
+        out->push_back(static_cast<std::byte>(v));
+    }
+
+    template <typename Value>
+    void raw(Value const& value) {
+        auto const p = reinterpret_cast<std::byte const*>(&value);
+        out->insert(out->end(), p, p + sizeof value);
+    }
+
+    template <typename Value>
+    void value(Value const& v) {
+        if constexpr (std::is_same_v<Value, bool>) {
+            out->push_back(static_cast<std::byte>(v));
+        } else if constexpr (std::is_integral_v<Value> && std::is_signed_v<Value>) {
+            varint(detail::binary::zigzag(v));
+        } else if constexpr (std::is_integral_v<Value>) {
+            varint(v);
+        } else if constexpr (std::is_same_v<Value, std::nullptr_t>) {
+        } else if constexpr (std::is_pointer_v<Value>) {
+            varint(reinterpret_cast<std::uintptr_t>(v));
+        } else {
+            static_assert(std::is_trivially_copyable_v<Value>,
+                    "forwarded arguments must be trivially copyable");
+            raw(v);
+        }
+    }
+
+    void string(char const* const str, std::size_t const size) {
+        if (!str) return varint(0);
+        if (intern) {
+            auto const key = std::string_view{str, size};
+            if (auto const it = interned.find(key); it != interned.end())
+                return varint(std::uint64_t{it->second} << 1 | 1);
+            if (interned.size() < intern_limit) {
+                auto const& stored = strings.emplace_back(key);
+                interned.emplace(stored, interned.size());
+            }
+        }
+        varint((std::uint64_t{size} + 1) << 1);
+        out->insert(out->end(), reinterpret_cast<std::byte const*>(str),
+                reinterpret_cast<std::byte const*>(str) + size);
+    }
+
+private:
+    std::vector<std::byte>* out;
+    bool intern;
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, std::uint32_t> interned;
+};
+
+// Reads values written by `binary_encoder`. Errors (truncation, bad
+// references) are sticky: once `failed()`, every value reads as zero.
+class binary_decoder {
+public:
+    binary_decoder(std::span<std::byte const> const in,
+            bool const intern = false) noexcept
+        : p{in.data()}, end{in.data() + in.size()}, intern{intern} {}
+
+    bool failed() const noexcept { return error; }
+    bool at_end() const noexcept { return p == end; }
+    std::byte const* position() const noexcept { return p; }
+
+    std::uint64_t varint() noexcept {
+        auto v = std::uint64_t{};
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            auto const b = static_cast<std::uint8_t>(*p++);
+            v |= std::uint64_t{b & 0x7fu} << shift;
+            if (!(b & 0x80)) return v;
+        }
+        error = true;
+        return 0;
+    }
+
+    template <typename Value>
+    Value raw() noexcept {
+        auto v = Value{};
+        if (static_cast<std::size_t>(end - p) < sizeof v) {
+            error = true;
+        } else {
+            std::memcpy(&v, p, sizeof v);
+            p += sizeof v;
+        }
+        return v;
+    }
+
+    template <typename Value>
+    Value value() noexcept {
+        if constexpr (std::is_same_v<Value, bool>) {
+            return raw<std::uint8_t>() != 0;
+        } else if constexpr (std::is_integral_v<Value> && std::is_signed_v<Value>) {
+            return static_cast<Value>(detail::binary::unzigzag(varint()));
+        } else if constexpr (std::is_integral_v<Value>) {
+            return static_cast<Value>(varint());
+        } else if constexpr (std::is_same_v<Value, std::nullptr_t>) {
+            return nullptr;
+        } else if constexpr (std::is_pointer_v<Value>) {
+            return reinterpret_cast<Value>(static_cast<std::uintptr_t>(varint()));
+        } else {
+            return raw<Value>();
+        }
+    }
+
+    // Returns a null-terminated string (or null) that remains valid until
+    // `next_record()`, or for the life of the decoder if it was interned.
+    char const* string(std::size_t& size) {
+        auto const h = varint();
+        if (h == 0) return (size = 0), nullptr;
+        if (h & 1) {
+            if (h / 2 >= strings.size()) return (error = true), "";
+            auto const& str = strings[h / 2];
+            return (size = str.size()), str.c_str();
+        }
+        size = h / 2 - 1;
+        if (static_cast<std::size_t>(end - p) < size) return (error = true), "";
+        auto const str = reinterpret_cast<char const*>(p);
+        p += size;
+        auto& stored = intern && strings.size() < binary_encoder::intern_limit
+                ? strings.emplace_back(str, size)
+                : scratch.emplace_back(str, size);
+        return stored.c_str();
+    }
+
+    void next_record() noexcept { scratch.clear(); }
+
+private:
+    std::byte const* p;
+    std::byte const* end;
+    bool intern;
+    bool error = false;
+    std::deque<std::string> strings;
+    std::deque<std::string> scratch;
+};
+
+namespace detail {
+namespace binary {
+
+// The compact encoding of a single argument, mirroring `packing::codec`.
+template <typename Arg>
+struct codec {
+    static_assert(!concepts::element_range<Arg> || std::is_array_v<Arg>,
+            "ranges cannot be encoded (binary formats do not print them)");
+
+    using forwarded = decltype(fwd_args(std::declval<Arg const&>()));
+
+    static void encode(binary_encoder& e, Arg const& arg) {
+        std::apply([&](auto const&... values) { (e.value(values), ...); },
+                fwd_args(arg));
+    }
+    static forwarded decode(binary_decoder& d) noexcept {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            // Braced initialization guarantees left-to-right evaluation.
+            return forwarded{
+                    d.value<std::tuple_element_t<I, forwarded>>()...};
+        }(std::make_index_sequence<std::tuple_size_v<forwarded>>{});
+    }
+};
+
+template <packing::c_str_type Arg>
+struct codec<Arg> {
+    static void encode(binary_encoder& e, Arg const& arg) {
+        auto const str = arg.c_str();
+        e.string(str, std::strlen(str));
+    }
+    static std::tuple<char const*> decode(binary_decoder& d) {
+        auto size = std::size_t{};
+        auto const str = d.string(size);
+        return {str ? str : ""};
+    }
+};
+
+template <packing::counted_chars Arg>
+struct codec<Arg> {
+    static void encode(binary_encoder& e, Arg const& arg) {
+        e.string(std::data(arg), std::size(arg));
+    }
+    static std::tuple<int, char const*> decode(binary_decoder& d) {
+        auto size = std::size_t{};
+        auto const str = d.string(size);
+        return {static_cast<int>(size), str};
+    }
+};
+
+template <packing::char_pointer Arg>
+struct codec<Arg> {
+    static void encode(binary_encoder& e, char const* const str) {
+        e.string(str, str ? std::strlen(str) : 0);
+    }
+    static std::tuple<char const*> decode(binary_decoder& d) {
+        auto size = std::size_t{};
+        return {d.string(size)};
+    }
+};
+
+template <concepts::renders Arg>
+struct codec<Arg> {
+    static void encode(binary_encoder& e, Arg const& arg) {
+        char text[traits<Arg>::capacity];
+        e.string(text, static_cast<std::size_t>(
+                traits<Arg>::render(text, arg) - text));
+    }
+    static std::tuple<char const*> decode(binary_decoder& d) {
+        auto size = std::size_t{};
+        auto const str = d.string(size);
+        return {str ? str : ""};
+    }
+};
+
+template <concepts::composite Arg>
+struct codec<Arg> {
+    template <typename Member>
+    using member_codec = codec<std::remove_cvref_t<Member>>;
+
+    static void encode(binary_encoder& e, Arg const& arg) {
+        std::apply([&](auto const&... members) {
+                (member_codec<decltype(members)>::encode(e, members), ...);
+            }, traits<Arg>::fwd_args(arg));
+    }
+    static auto decode(binary_decoder& d) {
+        return [&]<typename... Members>(std::type_identity<std::tuple<Members...>>) {
+            // Braced initialization guarantees left-to-right evaluation.
+            auto const parts = std::tuple<
+                    decltype(member_codec<Members>::decode(d))...>{
+                    member_codec<Members>::decode(d)...};
+            return std::apply([](auto const&... parts) {
+                    return std::tuple_cat(parts...);
+                }, parts);
+        }(std::type_identity<members_of<Arg>>{});
+    }
+};
+
+// Formats forwarded arguments into `out`.
+template <literal Fmt, typename... Args>
+struct formatter {
+    bool operator()(auto const&... args) const {
+        static constexpr auto fmt = build_fmt<Fmt, Args...>();
+        auto const size = std::snprintf(nullptr, 0, fmt.data, args...);
+        if (size < 0) return false;
+        out.resize(size);
+        std::snprintf(out.data(), size + 1, fmt.data, args...);
+        return true;
+    }
+    std::string& out;
+};
+
+template <literal Fmt, typename... Args>
+bool decode(binary_decoder& d, std::string& out) {
+    auto const values = std::tuple<decltype(codec<Args>::decode(d))...>{
+            codec<Args>::decode(d)...};
+    if (d.failed()) return false;
+    return std::apply([&](auto const&... forwarded) {
+        return std::apply(formatter<Fmt, Args...>{out},
+                std::tuple_cat(forwarded...));
+    }, values);
+}
+
+template <literal Fmt, typename... Args>
+bool format_packed(std::byte const* const in, std::string& out) {
+    return packed_args<Args...>::apply(in, formatter<Fmt, Args...>{out});
+}
+
+template <literal Fmt, typename... Args>
+struct catalog_entry {
+    static constinit binary_format format;
+    static inline bool const linked = link(format);
+};
+
+template <literal Fmt, typename... Args>
+constinit binary_format catalog_entry<Fmt, Args...>::format = {
+    format_id<Fmt, Args...>(), Fmt.data, &decode<Fmt, Args...>,
+    &format_packed<Fmt, Args...>, 0u, nullptr
+};
+
+} // namespace binary
+} // namespace detail
+
+/**
+ * Writes a compact binary log. Each record holds the format (by a
+ * stream-local index, defined on first use), the timestamp (as a zigzag
+ * varint delta from the previous record), and the compactly encoded
+ * arguments. The argument types are implied by the format, so no type
+ * information is stored per record.
+ *
+ * Each record is handed to `sink` as a `std::span<std::byte const>`, in
+ * order; the concatenation of the spans is the stream.
+ *
+ * Stream layout:
+ *
+ *     stream     := "PXB" version:u8 flags:u8 record*
+ *     record     := varint(index << 1) varint(zigzag(delta_ns)) argument*
+ *                 | varint(1) id:u64    (defines the next format index)
+ */
+template <typename Sink>
+class binary_writer {
+public:
+    explicit binary_writer(Sink sink, bool const intern_strings = false)
+        : sink{std::move(sink)}, encoder{buffer, intern_strings} {
+        using namespace detail::binary;
+        buffer.assign(std::begin(magic), std::end(magic));
+        buffer.push_back(intern_strings ? std::byte{interned_strings} : std::byte{});
+    }
+
+    // The encoder writes to `buffer`, so a moved writer is pointed at its own.
+    binary_writer(binary_writer&& other)
+        : sink{std::move(other.sink)}, buffer{std::move(other.buffer)},
+          encoder{std::move(other.encoder)}, local{std::move(other.local)},
+          defined{other.defined}, last{other.last} {
+        encoder.retarget(buffer);
+    }
+    binary_writer& operator=(binary_writer&&) = delete;
+
+    // Writes a record stamped with the current time (system clock).
+    template <literal Fmt, typename... Args>
+    void write(Args const&... args) {
+        using namespace std::chrono;
+        write_at<Fmt>(duration_cast<nanoseconds>(
+                system_clock::now().time_since_epoch()).count(), args...);
+    }
+
+    // Writes a record stamped with `timestamp` (nanoseconds).
+    template <literal Fmt, typename... Args>
+    void write_at(std::int64_t const timestamp, Args const&... args) {
+        using entry = detail::binary::catalog_entry<Fmt,
+                std::remove_cvref_t<Args>...>;
+        (void)&entry::linked;
+        auto const global = entry::format.index;
+        if (global >= local.size()) local.resize(global + 1);
+        if (local[global] == 0) {
+            encoder.varint(1);
+            encoder.raw(entry::format.id);
+            local[global] = ++defined;
+        }
+        encoder.varint(std::uint64_t{local[global] - 1} << 1);
+        encoder.varint(detail::binary::zigzag(timestamp - last));
+        last = timestamp;
+        (detail::binary::codec<std::remove_cvref_t<Args>>::encode(encoder, args), ...);
+        sink(std::span<std::byte const>{buffer});
+        buffer.clear();
+    }
+
+private:
+    Sink sink;
+    std::vector<std::byte> buffer;
+    binary_encoder encoder;
+    std::vector<std::uint32_t> local; // catalog index -> stream index + 1
+    std::uint32_t defined = 0;
+    std::int64_t last = 0;
+};
+
+// A decoded record.
+struct binary_entry {
+    std::int64_t timestamp;        // nanoseconds
+    binary_format const* format;
+    std::string text;              // the formatted output
+};
+
+/**
+ * Reads a stream written by `binary_writer`, formatting each record with the
+ * catalog of the running program.
+ */
+class binary_reader {
+public:
+    explicit binary_reader(std::span<std::byte const> const stream)
+        : decoder{valid(stream) ? stream.subspan(detail::binary::header_size)
+                                : stream.first(0),
+                valid(stream) && (std::to_integer<std::uint8_t>(stream[4])
+                        & detail::binary::interned_strings)} {
+        if (!valid(stream)) error = "not a printx binary log";
+    }
+
+    // Decodes the next record into `entry`. Returns false at the end of the
+    // stream or on error (see `error`).
+    bool next(binary_entry& entry) {
+        while (!error && !decoder.at_end()) {
+            decoder.next_record();
+            auto const tag = decoder.varint();
+            if (tag == 1) {
+                auto const id = decoder.raw<std::uint64_t>();
+                auto const format = find_binary_format(id);
+                if (!format) return fail("format not found in catalog");
+                formats.push_back(format);
+                continue;
+            }
+            if (tag & 1 || tag / 2 >= formats.size())
+                return fail("corrupt record");
+            last += detail::binary::unzigzag(decoder.varint());
+            entry.timestamp = last;
+            entry.format = formats[tag / 2];
+            if (decoder.failed() || !entry.format->decode(decoder, entry.text))
+                return fail("corrupt record");
+            return true;
+        }
+        return false;
+    }
+
+    // A description of the error that stopped reading, or null.
+    char const* error = nullptr;
+
+private:
+    static bool valid(std::span<std::byte const> const stream) noexcept {
+        using namespace detail::binary;
+        return stream.size() >= header_size
+                && std::equal(std::begin(magic), std::end(magic), stream.data());
+    }
+
+    bool fail(char const* const message) noexcept {
+        error = message;
+        return false;
+    }
+
+    binary_decoder decoder;
+    std::vector<binary_format const*> formats;
+    std::int64_t last = 0;
+};
+
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_BINARY_HPP
@@ -0,0 +1,1315 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_ENGINE_HPP
+#define ROSTD_PRINTX_ENGINE_HPP
+
+#include <rostd/printx.hpp>
+#include <array>
+#include <bit>
+#include <climits>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+#endif
+
+// The floating-point conversions are the largest part of the engine, and may
+// be left out of builds that do not need them (such as small firmware) by
+// defining this as 0. Formats that use them then fail to compile.
+#if !defined(ROSTD_PRINTX_NATIVE_FLOAT)
+    #define ROSTD_PRINTX_NATIVE_FLOAT 1
+#endif
+
+namespace rostd {
+namespace printx {
+
+/**
+ * The native engine formats printx arguments with kernels in this library,
+ * rather than handing a transformed format to the C library. The transformed
+ * format is parsed into a plan at compile time, so formatting is a fixed
+ * sequence of copies and conversions with no interpretation at run time, no
+ * allocation, no locks, and no dependency on `printf`.
+ *
+ * Output goes to a sink: any object with a `write(char const*, std::size_t)`
+ * member. The engine implements the conversions in `native_conversions`, and
+ * formats that use any other are rejected at compile time. Kernels are
+ * templates, so a program contains only those for the conversions it uses.
+ *
+ * The engine does not depend on `<cstdio>`, and with `printx.hpp` in its
+ * freestanding mode (`ROSTD_PRINTX_FREESTANDING`) it is usable without a C
+ * library `printf`.
+ */
+inline constexpr unsigned native_conversions = detail::integer_conversions
+        | detail::string_conversions | detail::pointer_conversions
+        | detail::position_conversions | detail::range_conversions
+        | detail::escape_conversions
+#if ROSTD_PRINTX_NATIVE_FLOAT
+        | detail::float_conversions
+#endif
+        ;
+
+namespace concepts {
+
+template <typename Sink>
+concept sink = requires(Sink& s, char const* p, std::size_t n) { s.write(p, n); };
+
+} // namespace concepts
+
+// A sink that writes into a character array with the semantics of `snprintf`:
+// output beyond the capacity is discarded, and the array always holds a
+// null-terminated string (unless its capacity is zero).
+class buffer_sink {
+public:
+    constexpr buffer_sink(char* const s, std::size_t const n) noexcept
+        : out{n ? s : nullptr}, room{n ? n - 1 : 0} {
+        if (out) *out = '\0';
+    }
+
+    constexpr void write(char const* p, std::size_t n) noexcept {
+        if (n > room) n = room;
+        room -= n;
+        while (n--) *out++ = *p++;
+        if (out) *out = '\0';
+    }
+
+private:
+    char* out;
+    std::size_t room;
+};
+
+// A sink that passes each character to a function, such as a UART's `putc`.
+template <typename Putc>
+    requires std::invocable<Putc&, char>
+class putc_sink {
+public:
+    constexpr explicit putc_sink(Putc putc) noexcept : putc{putc} {}
+
+    constexpr void write(char const* p, std::size_t n) {
+        while (n--) putc(*p++);
+    }
+
+private:
+    Putc putc;
+};
+
+namespace detail {
+namespace native {
+
+enum : unsigned { left = 1, plus = 2, space = 4, alternate = 8, zero_pad = 16 };
+enum class length : char { none, hh, h, l, ll, j, z, t, L };
+enum class escaping : char { none, json, c, csv };
+inline constexpr int none = -1;      // width or precision not specified
+inline constexpr int from_arg = -2;  // width or precision given by `*`
+
+// A run of literal text followed by a conversion (or by nothing, if `type` is
+// zero). Arguments are consumed in order: the width and the precision (when
+// they are `*`), then the value. A range conversion applies to each element
+// of its value, with the separator text between them (or between groups of
+// `group` elements). A string conversion may escape its value.
+struct segment {
+    std::size_t text = 0;
+    std::size_t size = 0;
+    char type = '\0';
+    length size_of = length::none;
+    unsigned flags = 0;
+    int width = none;
+    int precision = none;
+    std::size_t arg = 0;
+    bool range = false;
+    std::size_t group = 0;
+    std::size_t separator = 0;
+    std::size_t separator_size = 0;
+    escaping escape = escaping::none;
+};
+
+// The run-time form of a conversion, once `*` fields have been resolved.
+struct conversion {
+    unsigned flags;
+    int width;
+    int precision;
+};
+
+constexpr unsigned flag_of(char const ch) noexcept {
+    switch (ch) {
+    case '-': return left;
+    case '+': return plus;
+    case ' ': return space;
+    case '#': return alternate;
+    case '0': return zero_pad;
+    }
+    return 0;
+}
+
+constexpr std::size_t count_segments(char const* p) noexcept {
+    auto n = std::size_t{1};
+    for (; *p; ++p) {
+        if (*p == '%') ++n, ++p;
+    }
+    return n;
+}
+
+// Parses a transformed (and therefore valid) format into `count_segments(s)`
+// segments. An escaped '%' ends a segment after the first '%', and the next
+// one starts after the second.
+constexpr void parse_plan(char const* const s, segment* const plan) noexcept {
+    std::size_t i = 0, pos = 0, start = 0, arg = 0;
+    auto const number = [&] {
+        auto n = 0;
+        while (s[pos] >= '0' && s[pos] <= '9') n = n * 10 + (s[pos++] - '0');
+        return n;
+    };
+    while (s[pos]) {
+        if (s[pos] != '%') { ++pos; continue; }
+        auto& seg = plan[i++];
+        seg.text = start;
+        seg.arg = arg;
+        if (s[pos + 1] == '%') {
+            seg.size = pos + 1 - start;
+            start = pos += 2;
+            continue;
+        }
+        seg.size = pos++ - start;
+        if (s[pos] == '{') {
+            seg.escape = s[pos + 1] == 'j' ? escaping::json
+                    : s[pos + 2] == 's' ? escaping::csv : escaping::c;
+            while (s[pos++] != '}') {}
+        }
+        auto digits = pos;
+        while (s[digits] >= '0' && s[digits] <= '9') ++digits;
+        if (s[digits] == '[') {
+            seg.range = true;
+            seg.group = static_cast<std::size_t>(number());
+            seg.separator = ++pos;
+            while (s[pos] != ']') ++pos;
+            seg.separator_size = pos++ - seg.separator;
+        }
+        while (auto const f = flag_of(s[pos])) seg.flags |= f, ++pos;
+        if (s[pos] == '*') {
+            seg.width = from_arg;
+            ++arg, ++pos;
+        } else if (s[pos] >= '0' && s[pos] <= '9') {
+            seg.width = number();
+        }
+        if (s[pos] == '.') {
+            if (s[++pos] == '*') {
+                seg.precision = from_arg;
+                ++arg, ++pos;
+            } else {
+                seg.precision = number();
+            }
+        }
+        switch (s[pos]) {
+        case 'h': seg.size_of = s[pos + 1] == 'h' ? length::hh : length::h; break;
+        case 'l': seg.size_of = s[pos + 1] == 'l' ? length::ll : length::l; break;
+        case 'j': seg.size_of = length::j; break;
+        case 'z': seg.size_of = length::z; break;
+        case 't': seg.size_of = length::t; break;
+        case 'L': seg.size_of = length::L; break;
+        }
+        while (std::string_view{"hljztLq"}.find(s[pos]) != std::string_view::npos)
+            ++pos;
+        seg.type = s[pos++];
+        ++arg;
+        start = pos;
+    }
+    plan[i] = segment{start, pos - start};
+}
+
+template <literal Fmt>
+consteval auto make_plan() noexcept {
+    auto plan = std::array<segment, count_segments(Fmt.data)>{};
+    parse_plan(Fmt.data, plan.data());
+    return plan;
+}
+
+template <literal Fmt>
+inline constexpr auto plan = make_plan<Fmt>();
+
+// Forwards to a sink, counting the characters written.
+template <typename Sink>
+struct writer {
+    Sink& sink;
+    std::size_t count = 0;
+
+    constexpr void write(char const* const p, std::size_t const n) {
+        if (n == 0) return;
+        sink.write(p, n);
+        count += n;
+    }
+
+    constexpr void fill(char const ch, int n) {
+        char chunk[16];
+        for (auto& c : chunk) c = ch;
+        for (; n > 0; n -= 16) write(chunk, static_cast<std::size_t>(n < 16 ? n : 16));
+    }
+};
+
+inline constexpr auto digit_pairs = [] {
+    auto pairs = std::array<char, 200>{};
+    for (std::size_t i = 0; i < 100; ++i) {
+        pairs[2 * i] = static_cast<char>('0' + i / 10);
+        pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+    }
+    return pairs;
+}();
+
+// Writes the digits of `value` backwards from `end`, and returns the first.
+template <typename Unsigned>
+constexpr char* to_chars(char* end, Unsigned value, char const type) noexcept {
+    if (type == 'o') {
+        do { *--end = static_cast<char>('0' + (value & 7)); } while (value >>= 3);
+    } else if (type == 'x' || type == 'X') {
+        auto const digits = type == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+        do { *--end = digits[value & 15]; } while (value >>= 4);
+    } else {
+        while (value >= 100) {
+            auto const r = static_cast<std::size_t>(value % 100) * 2;
+            value /= 100;
+            *--end = digit_pairs[r + 1];
+            *--end = digit_pairs[r];
+        }
+        if (value >= 10) {
+            auto const r = static_cast<std::size_t>(value) * 2;
+            *--end = digit_pairs[r + 1];
+            *--end = digit_pairs[r];
+        } else {
+            *--end = static_cast<char>('0' + value);
+        }
+    }
+    return end;
+}
+
+// Text, padded to the field width.
+template <typename Writer>
+constexpr void put_padded(Writer& out, conversion const& spec,
+        char const* const p, std::size_t const n) {
+    auto const pad = spec.width > 0 && static_cast<std::size_t>(spec.width) > n
+            ? spec.width - static_cast<int>(n) : 0;
+    if (!(spec.flags & left)) out.fill(' ', pad);
+    out.write(p, n);
+    if (spec.flags & left) out.fill(' ', pad);
+}
+
+// %d %i %u %o %x %X (and %p), given the magnitude and any sign character.
+template <typename Writer, typename Unsigned>
+constexpr void put_integer(Writer& out, conversion const& spec,
+        char const type, Unsigned const value, char const sign) {
+    char buffer[std::numeric_limits<Unsigned>::digits / 3 + 1];
+    auto const end = buffer + sizeof buffer;
+    auto const first = value != 0 || spec.precision != 0
+            ? to_chars(end, value, type) : end;
+    auto const digits = static_cast<int>(end - first);
+
+    char prefix[2] = {};
+    auto prefix_size = 0;
+    if (sign) prefix[prefix_size++] = sign;
+    if ((spec.flags & alternate) && value != 0 && (type == 'x' || type == 'X')) {
+        prefix[prefix_size++] = '0';
+        prefix[prefix_size++] = type;
+    }
+    auto zeros = spec.precision > digits ? spec.precision - digits : 0;
+    if ((spec.flags & alternate) && type == 'o' && zeros == 0
+            && (digits == 0 || *first != '0'))
+        zeros = 1;
+    auto const size = prefix_size + zeros + digits;
+    auto pad = spec.width > size ? spec.width - size : 0;
+    if ((spec.flags & zero_pad) && !(spec.flags & left) && spec.precision < 0) {
+        zeros += pad;
+        pad = 0;
+    }
+    if (!(spec.flags & left)) out.fill(' ', pad);
+    out.write(prefix, static_cast<std::size_t>(prefix_size));
+    out.fill('0', zeros);
+    out.write(first, static_cast<std::size_t>(digits));
+    if (spec.flags & left) out.fill(' ', pad);
+}
+
+// The type that `printf` reads for a length sub-specifier, after the argument
+// has undergone the default promotions.
+template <length Length, bool Signed>
+struct integer_of {
+    using type = std::conditional_t<Signed, int, unsigned>;
+};
+template <bool Signed> struct integer_of<length::hh, Signed>
+    { using type = std::conditional_t<Signed, signed char, unsigned char>; };
+template <bool Signed> struct integer_of<length::h, Signed>
+    { using type = std::conditional_t<Signed, short, unsigned short>; };
+template <bool Signed> struct integer_of<length::l, Signed>
+    { using type = std::conditional_t<Signed, long, unsigned long>; };
+template <bool Signed> struct integer_of<length::ll, Signed>
+    { using type = std::conditional_t<Signed, long long, unsigned long long>; };
+template <bool Signed> struct integer_of<length::j, Signed>
+    { using type = std::conditional_t<Signed, std::intmax_t, std::uintmax_t>; };
+template <bool Signed> struct integer_of<length::z, Signed>
+    { using type = std::make_signed_t<std::size_t>; };
+template <> struct integer_of<length::z, false> { using type = std::size_t; };
+template <bool Signed> struct integer_of<length::t, Signed>
+    { using type = std::ptrdiff_t; };
+template <> struct integer_of<length::t, false>
+    { using type = std::make_unsigned_t<std::ptrdiff_t>; };
+
+#if ROSTD_PRINTX_NATIVE_FLOAT
+// A finite or non-finite floating-point value, as `mantissa * 2^exponent`.
+template <typename Float>
+struct float_parts {
+    using limits = std::numeric_limits<Float>;
+#if defined(__SIZEOF_INT128__)
+    __extension__ using wide = unsigned __int128;
+    using mantissa_type = std::conditional_t<(limits::digits > 64), wide, std::uint64_t>;
+#else
+    using mantissa_type = std::uint64_t;
+#endif
+    mantissa_type mantissa = 0;
+    int exponent = 0;
+    bool negative = false;
+    bool infinite = false;
+    bool nan = false;
+};
+
+template <std::size_t Size> struct bits_of { using type = std::uint64_t; };
+template <> struct bits_of<4> { using type = std::uint32_t; };
+#if defined(__SIZEOF_INT128__)
+template <> struct bits_of<16> { __extension__ using type = unsigned __int128; };
+#endif
+
+template <typename Float>
+constexpr float_parts<Float> decompose(Float const x) noexcept {
+    using parts = float_parts<Float>;
+    using mantissa_type = typename parts::mantissa_type;
+    constexpr int digits = parts::limits::digits;
+    constexpr int bias = parts::limits::max_exponent - 1;
+    auto p = parts{};
+    if constexpr (digits == 64) { // x87 extended precision: explicit integer bit
+        if (std::is_constant_evaluated()) {
+            p.negative = __builtin_signbit(x);
+            p.nan = __builtin_isnan(x);
+            p.infinite = __builtin_isinf(x);
+            if (p.nan || p.infinite || x == 0) return p;
+            auto y = p.negative ? -x : x;
+            for (; y >= 0x1p64L; y *= 0x1p-64L) p.exponent += 64;
+            for (; y < 0x1p-64L; y *= 0x1p64L) p.exponent -= 64;
+            for (; y >= 2; y /= 2) ++p.exponent;
+            for (; y < 1; y *= 2) --p.exponent;
+            p.mantissa = static_cast<mantissa_type>(y * 0x1p63L);
+            p.exponent -= 63;
+            return p;
+        }
+        unsigned char bytes[sizeof x];
+        __builtin_memcpy(bytes, &x, sizeof x);
+        for (int i = 7; i >= 0; --i) p.mantissa = p.mantissa << 8 | bytes[i];
+        auto const biased = (bytes[9] & 0x7f) << 8 | bytes[8];
+        p.negative = bytes[9] & 0x80;
+        if (biased == 0x7fff) {
+            p.nan = (p.mantissa << 1) != 0;
+            p.infinite = !p.nan;
+        } else {
+            p.exponent = (biased ? biased : 1) - bias - (digits - 1);
+        }
+    } else {
+        using bits_type = typename bits_of<sizeof x>::type;
+        constexpr int fraction_bits = digits - 1;
+        constexpr int exponent_bits = int{sizeof x} * 8 - 1 - fraction_bits;
+        auto const bits = std::bit_cast<bits_type>(x);
+        auto const biased = static_cast<int>(bits >> fraction_bits)
+                & ((1 << exponent_bits) - 1);
+        auto const fraction = static_cast<mantissa_type>(bits)
+                & ((mantissa_type{1} << fraction_bits) - 1);
+        p.negative = (bits >> (sizeof x * 8 - 1)) != 0;
+        if (biased == (1 << exponent_bits) - 1) {
+            p.nan = fraction != 0;
+            p.infinite = !p.nan;
+        } else {
+            p.mantissa = biased ? fraction | mantissa_type{1} << fraction_bits
+                                : fraction;
+            p.exponent = (biased ? biased : 1) - bias - fraction_bits;
+        }
+    }
+    return p;
+}
+
+inline constexpr std::uint32_t powers_of_ten[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+// The exact decimal expansion of a finite value, as an integer in base 10^9
+// scaled by a power of ten. Every binary fraction has a finite decimal
+// expansion: `m * 2^-k` is `m * 5^k * 10^-k`.
+template <typename Float>
+class decimal {
+public:
+    template <typename Parts>
+    constexpr explicit decimal(Parts const& p) noexcept {
+        for (auto m = p.mantissa; m != 0; m /= 1'000'000'000)
+            limbs[size++] = static_cast<std::uint32_t>(m % 1'000'000'000);
+        auto scale = 0;
+        if (p.exponent > 0) {
+            auto e = p.exponent;
+            for (; e >= 29; e -= 29) multiply(std::uint32_t{1} << 29);
+            multiply(std::uint32_t{1} << e);
+        } else if (p.exponent < 0) {
+            scale = -p.exponent;
+            auto k = scale;
+            for (; k >= 13; k -= 13) multiply(1'220'703'125); // 5^13
+            auto f = std::uint32_t{1};
+            while (k--) f *= 5;
+            multiply(f);
+        }
+        if (size == 0) return;
+        top = 1;
+        while (top < 9 && limbs[size - 1] >= powers_of_ten[top]) ++top;
+        count = top + 9 * (size - 1);
+        exponent = count - 1 - scale;
+    }
+
+    // The `j`th significant digit (zero beyond the last). The first has
+    // weight `10^exponent`.
+    constexpr int digit(int const j) const noexcept {
+        if (j < 0 || j >= count) return 0;
+        if (j < top) return static_cast<int>(limbs[size - 1] / powers_of_ten[top - 1 - j] % 10);
+        auto const q = j - top;
+        return static_cast<int>(limbs[size - 2 - q / 9] / powers_of_ten[8 - q % 9] % 10);
+    }
+
+    // Whether any digit after the `j`th is non-zero.
+    constexpr bool nonzero_after(int const j) const noexcept {
+        auto const i = j + 1 < 0 ? 0 : j + 1;
+        if (i >= count) return false;
+        auto const q = i - top;
+        auto const limb = i < top ? size - 1 : size - 2 - q / 9;
+        auto const remaining = i < top ? top - i : 9 - q % 9;
+        if (remaining < 9 && limbs[limb] % powers_of_ten[remaining] != 0) return true;
+        if (remaining == 9 && limbs[limb] != 0) return true;
+        for (auto k = 0; k < limb; ++k) if (limbs[k] != 0) return true;
+        return false;
+    }
+
+    int exponent = 0;
+
+private:
+    using limits = std::numeric_limits<Float>;
+    // Decimal digits in the largest integer, or in `2^digits * 5^k` for the
+    // smallest subnormal.
+    static constexpr int integer_digits = limits::max_exponent * 30103 / 100000;
+    static constexpr int fraction_digits = limits::digits * 30103 / 100000
+            + (limits::digits - limits::min_exponent) * 69897 / 100000;
+    static constexpr int max_digits = integer_digits > fraction_digits
+            ? integer_digits : fraction_digits;
+
+    constexpr void multiply(std::uint32_t const factor) noexcept {
+        auto carry = std::uint64_t{};
+        for (int i = 0; i < size; ++i) {
+            auto const x = std::uint64_t{limbs[i]} * factor + carry;
+            limbs[i] = static_cast<std::uint32_t>(x % 1'000'000'000);
+            carry = x / 1'000'000'000;
+        }
+        for (; carry != 0; carry /= 1'000'000'000)
+            limbs[size++] = static_cast<std::uint32_t>(carry % 1'000'000'000);
+    }
+
+    std::uint32_t limbs[max_digits / 9 + 3] = {};
+    int size = 0;
+    int top = 0;    // digits in the most significant limb
+    int count = 0;  // significant digits
+};
+
+// The first `keep` significant digits of a decimal, rounded to nearest with
+// ties to even (as glibc does in the default rounding mode).
+template <typename Decimal>
+struct rounded {
+    constexpr rounded(Decimal const& d, int const keep) noexcept
+        : d{d}, exponent{d.exponent}, keep{keep} {
+        if (keep < 0) { // everything is discarded, and it is under half
+            this->keep = 0;
+            return;
+        }
+        auto const next = d.digit(keep);
+        auto up = next > 5;
+        if (next == 5) {
+            up = (keep > 0 && d.digit(keep - 1) % 2 != 0)
+                    || d.nonzero_after(keep);
+        }
+        if (!up) return;
+        last = keep - 1;
+        while (last >= 0 && d.digit(last) == 9) --last;
+        if (last < 0) ++exponent, ++this->keep; // 99.9 becomes 100.0
+    }
+
+    constexpr int digit(int const j) const noexcept {
+        if (j < 0 || j >= keep) return 0;
+        if (last == none_rounded) return d.digit(j);
+        if (last < 0) return j == 0;
+        return j < last ? d.digit(j) : j == last ? d.digit(j) + 1 : 0;
+    }
+
+    // The digit with weight `10^w`.
+    constexpr int at(int const w) const noexcept { return digit(exponent - w); }
+
+    static constexpr int none_rounded = INT_MAX;
+    Decimal const& d;
+    int exponent;
+    int keep;
+    int last = none_rounded;
+};
+
+// Collects characters for a writer in small batches.
+template <typename Writer>
+struct batch {
+    Writer& out;
+    char buffer[64] = {};
+    std::size_t used = 0;
+
+    constexpr void put(char const ch) {
+        if (used == sizeof buffer) flush();
+        buffer[used++] = ch;
+    }
+    constexpr void flush() {
+        out.write(buffer, used);
+        used = 0;
+    }
+};
+
+// Writes padding, the sign and any prefix, and leaves the body to `body`.
+template <typename Writer, typename Body>
+constexpr void put_float_field(Writer& out, conversion const& spec,
+        char const sign, char const* const prefix, int const size,
+        bool const finite, Body const& body) {
+    auto const prefix_size = sign ? 1 : 0;
+    auto const total = prefix_size + static_cast<int>(
+            std::char_traits<char>::length(prefix)) + size;
+    auto const pad = spec.width > total ? spec.width - total : 0;
+    auto const zeros = finite && (spec.flags & zero_pad) && !(spec.flags & left);
+    if (!(spec.flags & left) && !zeros) out.fill(' ', pad);
+    if (sign) out.write(&sign, 1);
+    out.write(prefix, std::char_traits<char>::length(prefix));
+    if (zeros) out.fill('0', pad);
+    auto b = batch<Writer>{out};
+    body(b);
+    b.flush();
+    if (spec.flags & left) out.fill(' ', pad);
+}
+
+// %f %F, and %g %G in fixed notation (`strip` removes trailing zeros).
+template <typename Writer, typename Decimal>
+constexpr void put_fixed(Writer& out, conversion const& spec, char const sign,
+        Decimal const& d, int const precision, bool const strip) {
+    auto const r = rounded{d, d.exponent + precision + 1};
+    auto const whole = r.exponent >= 0 ? r.exponent + 1 : 1;
+    auto fraction = precision;
+    if (strip) while (fraction > 0 && r.at(-fraction) == 0) --fraction;
+    auto const point = fraction > 0 || (spec.flags & alternate);
+    put_float_field(out, spec, sign, "", whole + point + fraction, true,
+            [&](auto& b) {
+                for (auto w = whole - 1; w >= 0; --w) b.put(static_cast<char>('0' + r.at(w)));
+                if (point) b.put('.');
+                for (auto w = -1; w >= -fraction; --w) b.put(static_cast<char>('0' + r.at(w)));
+            });
+}
+
+// %e %E, and %g %G in exponent notation.
+template <typename Writer, typename Decimal>
+constexpr void put_exponent(Writer& out, conversion const& spec, char const sign,
+        Decimal const& d, int const precision, bool const strip, char const e) {
+    auto const r = rounded{d, precision + 1};
+    auto fraction = precision;
+    if (strip) while (fraction > 0 && r.digit(fraction) == 0) --fraction;
+    auto const point = fraction > 0 || (spec.flags & alternate);
+    auto const x = r.exponent < 0 ? -r.exponent : r.exponent;
+    char exp[8];
+    auto const exp_end = exp + sizeof exp;
+    auto exp_first = to_chars(exp_end, static_cast<unsigned>(x), 'd');
+    if (x < 10) *--exp_first = '0';
+    auto const exp_size = static_cast<int>(exp_end - exp_first);
+    put_float_field(out, spec, sign, "", 1 + point + fraction + 2 + exp_size, true,
+            [&](auto& b) {
+                b.put(static_cast<char>('0' + r.digit(0)));
+                if (point) b.put('.');
+                for (auto j = 1; j <= fraction; ++j) b.put(static_cast<char>('0' + r.digit(j)));
+                b.put(e);
+                b.put(r.exponent < 0 ? '-' : '+');
+                for (auto p = exp_first; p != exp_end; ++p) b.put(*p);
+            });
+}
+
+// %a %A. The leading hex digit takes the bits that leave a whole number of
+// hex digits in the fraction, as glibc does: `0x1.8p+1` for double, and
+// `0xcp-2` for x87 long double.
+template <typename Writer, typename Parts>
+constexpr void put_hex_float(Writer& out, conversion const& spec, char const sign,
+        Parts const& p, bool const upper, int const digits) {
+    using mantissa_type = decltype(p.mantissa);
+    auto const fraction_bits = digits - ((digits - 1) % 4 + 1);
+    auto const hex_digits = fraction_bits / 4;
+    auto lead = static_cast<unsigned>(p.mantissa >> fraction_bits);
+    auto fraction = p.mantissa & ((mantissa_type{1} << fraction_bits) - 1);
+    auto exponent = p.mantissa == 0 ? 0 : p.exponent + fraction_bits;
+    auto precision = spec.precision;
+    if (precision < 0) {
+        precision = hex_digits;
+        while (precision > 0 && (fraction & 15) == 0) fraction >>= 4, --precision;
+    } else if (precision < hex_digits) {
+        auto const shift = (hex_digits - precision) * 4;
+        auto const rest = fraction & ((mantissa_type{1} << shift) - 1);
+        auto const half = mantissa_type{1} << (shift - 1);
+        fraction >>= shift;
+        auto const odd = precision > 0 ? (fraction & 1) != 0 : (lead & 1) != 0;
+        if (rest > half || (rest == half && odd)) {
+            if (precision > 0 && ++fraction >> (precision * 4)) fraction = 0, ++lead;
+            if (precision == 0) ++lead;
+        }
+        if (lead == 16) lead = 1, exponent += 4;
+    }
+    auto const shown = precision < hex_digits ? precision : hex_digits;
+    auto const point = precision > 0 || (spec.flags & alternate);
+    auto const x = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    char exp[8];
+    auto const exp_end = exp + sizeof exp;
+    auto const exp_first = to_chars(exp_end, x, 'd');
+    auto const exp_size = static_cast<int>(exp_end - exp_first);
+    auto const hex = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    put_float_field(out, spec, sign, upper ? "0X" : "0x",
+            1 + point + precision + 2 + exp_size, true, [&](auto& b) {
+                b.put(hex[lead]);
+                if (point) b.put('.');
+                for (auto i = shown - 1; i >= 0; --i)
+                    b.put(hex[static_cast<unsigned>(fraction >> (i * 4)) & 15]);
+                for (auto i = shown; i < precision; ++i) b.put('0');
+                b.put(upper ? 'P' : 'p');
+                b.put(exponent < 0 ? '-' : '+');
+                for (auto q = exp_first; q != exp_end; ++q) b.put(*q);
+            });
+}
+
+// %f %F %e %E %g %G %a %A, exactly (every digit of the decimal expansion is
+// correct, and rounding is to nearest with ties to even).
+template <char Type, typename Writer, typename Value>
+constexpr void put_float(Writer& out, conversion const& spec, Value const value) {
+    // `float` is promoted to `double` by varargs, so print it as `printf` would.
+    using Float = std::conditional_t<std::is_same_v<Value, float>, double, Value>;
+    auto const p = decompose(static_cast<Float>(value));
+    auto const sign = p.negative ? '-' : spec.flags & plus ? '+'
+            : spec.flags & space ? ' ' : '\0';
+    constexpr auto upper = Type == 'F' || Type == 'E' || Type == 'G' || Type == 'A';
+    if (p.nan || p.infinite) {
+        auto const text = p.nan ? upper ? "NAN" : "nan" : upper ? "INF" : "inf";
+        put_float_field(out, spec, sign, "", 3, false,
+                [&](auto& b) { for (auto c = text; *c; b.put(*c++)) {} });
+        return;
+    }
+    if constexpr (Type == 'a' || Type == 'A') {
+        put_hex_float(out, spec, sign, p, upper, std::numeric_limits<Float>::digits);
+    } else {
+        auto const precision = spec.precision < 0 ? 6 : spec.precision;
+        auto const d = decimal<Float>{p};
+        if constexpr (Type == 'f' || Type == 'F') {
+            put_fixed(out, spec, sign, d, precision, false);
+        } else if constexpr (Type == 'e' || Type == 'E') {
+            put_exponent(out, spec, sign, d, precision, false, upper ? 'E' : 'e');
+        } else {
+            auto const significant = precision == 0 ? 1 : precision;
+            auto const x = rounded{d, significant}.exponent;
+            auto const strip = !(spec.flags & alternate);
+            if (significant > x && x >= -4) {
+                put_fixed(out, spec, sign, d, significant - 1 - x, strip);
+            } else {
+                // As glibc does, a value that reaches `10^significant` only
+                // by rounding is shown without fraction digits ("1.e+02").
+                auto const fraction = x == significant && d.exponent < x
+                        ? 0 : significant - 1;
+                put_exponent(out, spec, sign, d, fraction, strip,
+                        upper ? 'E' : 'e');
+            }
+        }
+    }
+}
+#endif
+
+template <char Type, length Length, typename Writer, typename Value>
+constexpr void put(Writer& out, conversion const& spec, Value const& value) {
+    if constexpr (Type == 'd' || Type == 'i') {
+        using S = typename integer_of<Length, true>::type;
+        using U = std::common_type_t<unsigned, std::make_unsigned_t<S>>;
+        auto const v = static_cast<S>(+value);
+        auto const sign = v < 0 ? '-' : spec.flags & plus ? '+'
+                : spec.flags & space ? ' ' : '\0';
+        put_integer(out, spec, Type,
+                v < 0 ? static_cast<U>(0u - static_cast<U>(v)) : static_cast<U>(v),
+                sign);
+    } else if constexpr (Type == 'u' || Type == 'o' || Type == 'x' || Type == 'X') {
+        using U = typename integer_of<Length, false>::type;
+        put_integer(out, spec, Type,
+                static_cast<std::common_type_t<unsigned, U>>(static_cast<U>(+value)),
+                '\0');
+    } else if constexpr (Type == 'c') {
+        auto const ch = static_cast<char>(static_cast<unsigned char>(+value));
+        put_padded(out, spec, &ch, 1);
+    } else if constexpr (Type == 's' && requires { value.size; }) { // rendered
+        auto n = value.size;
+        if (spec.precision >= 0 && n > static_cast<std::size_t>(spec.precision))
+            n = static_cast<std::size_t>(spec.precision);
+        put_padded(out, spec, value.data, n);
+    } else if constexpr (Type == 's') {
+        char const* s = value;
+        if (!s) s = spec.precision < 0 || spec.precision >= 6 ? "(null)" : "";
+        auto n = std::size_t{};
+        if (spec.precision < 0) {
+            n = std::char_traits<char>::length(s);
+        } else {
+            while (n < static_cast<std::size_t>(spec.precision) && s[n]) ++n;
+        }
+        put_padded(out, spec, s, n);
+    } else if constexpr (Type == 'p') {
+        auto address = std::uintptr_t{};
+        if constexpr (requires { value.data(); }) // an array, as a span
+            address = reinterpret_cast<std::uintptr_t>(value.data());
+        else if constexpr (!std::is_null_pointer_v<Value>)
+            address = reinterpret_cast<std::uintptr_t>(std::decay_t<Value>(value));
+        if (address == 0) {
+            put_padded(out, spec, "(nil)", 5);
+        } else {
+            auto const sign = spec.flags & plus ? '+'
+                    : spec.flags & space ? ' ' : '\0';
+            put_integer(out, {spec.flags | alternate, spec.width, none}, 'x',
+                    address, sign);
+        }
+    } else if constexpr (Type == 'n') {
+        *value = static_cast<int>(out.count);
+#if ROSTD_PRINTX_NATIVE_FLOAT
+    } else if constexpr (std::is_floating_point_v<Value>) {
+        put_float<Type>(out, spec, value);
+#endif
+    } else {
+        static_assert(Type == 'd', "conversion not implemented by the native engine");
+    }
+}
+
+// Writes the two hex digits of each of `n` bytes to `out`, 32 or 16 bytes at
+// a time where the target has vector instructions.
+template <typename Byte>
+constexpr void hex_encode(char* out, Byte const* in, std::size_t n,
+        bool const upper) noexcept {
+    if (!std::is_constant_evaluated()) {
+        // What is added to a digit above 9 beyond '0', to make it a letter.
+        [[maybe_unused]] auto const alpha = static_cast<char>(
+                (upper ? 'A' : 'a') - '9' - 1);
+#if defined(__AVX2__)
+        auto const low = _mm256_set1_epi8(0x0f);
+        auto const nine = _mm256_set1_epi8(9);
+        auto const zero = _mm256_set1_epi8('0');
+        auto const letters = _mm256_set1_epi8(alpha);
+        auto const ascii = [&](__m256i const nibbles) {
+            auto const over = _mm256_cmpgt_epi8(nibbles, nine);
+            return _mm256_add_epi8(_mm256_add_epi8(nibbles, zero),
+                    _mm256_and_si256(over, letters));
+        };
+        for (; n >= 32; n -= 32, in += 32, out += 64) {
+            auto const v = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(in));
+            auto const hi = ascii(_mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+            auto const lo = ascii(_mm256_and_si256(v, low));
+            // Unpacking interleaves within each 128-bit lane.
+            auto const a = _mm256_unpacklo_epi8(hi, lo);
+            auto const b = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                    _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32),
+                    _mm256_permute2x128_si256(a, b, 0x31));
+        }
+#endif
+#if defined(__SSE2__)
+        auto const low4 = _mm_set1_epi8(0x0f);
+        auto const nine4 = _mm_set1_epi8(9);
+        auto const zero4 = _mm_set1_epi8('0');
+        auto const letters4 = _mm_set1_epi8(alpha);
+        auto const ascii4 = [&](__m128i const nibbles) {
+            auto const over = _mm_cmpgt_epi8(nibbles, nine4);
+            return _mm_add_epi8(_mm_add_epi8(nibbles, zero4),
+                    _mm_and_si128(over, letters4));
+        };
+        for (; n >= 16; n -= 16, in += 16, out += 32) {
+            auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(in));
+            auto const hi = ascii4(_mm_and_si128(_mm_srli_epi16(v, 4), low4));
+            auto const lo = ascii4(_mm_and_si128(v, low4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                    _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16),
+                    _mm_unpackhi_epi8(hi, lo));
+        }
+#elif defined(__ARM_NEON)
+        auto const ascii = [&](uint8x16_t const nibbles) {
+            auto const over = vcgtq_u8(nibbles, vdupq_n_u8(9));
+            return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')),
+                    vandq_u8(over, vdupq_n_u8(static_cast<std::uint8_t>(alpha))));
+        };
+        for (; n >= 16; n -= 16, in += 16, out += 32) {
+            auto const v = vld1q_u8(reinterpret_cast<std::uint8_t const*>(in));
+            auto const pairs = uint8x16x2_t{{ascii(vshrq_n_u8(v, 4)),
+                    ascii(vandq_u8(v, vdupq_n_u8(0x0f)))}};
+            vst2q_u8(reinterpret_cast<std::uint8_t*>(out), pairs);
+        }
+#endif
+    }
+    auto const digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    for (; n; --n, ++in) {
+        auto const byte = static_cast<unsigned char>(*in);
+        *out++ = digits[byte >> 4];
+        *out++ = digits[byte & 15];
+    }
+}
+
+// A range of bytes as pairs of hex digits, in groups of `group` bytes with
+// the separator between them. The bytes are encoded a block at a time.
+template <typename Writer, typename Byte, std::size_t Extent>
+constexpr void put_hex_dump(Writer& out, std::span<Byte const, Extent> const bytes,
+        bool const upper, std::size_t const group,
+        std::string_view const separator) {
+    constexpr std::size_t block = 128;
+    char encoded[2 * block];
+    std::size_t in_group = 0;
+    for (std::size_t i = 0; i < bytes.size(); i += block) {
+        auto const n = bytes.size() - i < block ? bytes.size() - i : block;
+        hex_encode(encoded, bytes.data() + i, n, upper);
+        for (std::size_t done = 0; done < n;) {
+            if (in_group == group) {
+                out.write(separator.data(), separator.size());
+                in_group = 0;
+            }
+            auto const take = group - in_group < n - done
+                    ? group - in_group : n - done;
+            out.write(encoded + 2 * done, 2 * take);
+            done += take;
+            in_group += take;
+        }
+    }
+}
+
+// The value of an element of a range, as it would have been forwarded.
+template <typename Element>
+constexpr auto element_value(Element const element) noexcept {
+    if constexpr (std::is_enum_v<Element>)
+        return static_cast<std::underlying_type_t<Element>>(element);
+    else
+        return element;
+}
+
+// Each element of a range, with the separator between elements (or between
+// groups of `Seg.group` elements). In a range, %c prints bytes that are not
+// printable ASCII as '.', as the text column of a hex dump. Bytes printed as
+// exactly two hex digits are encoded together, see `put_hex_dump`.
+template <literal Fmt, segment Seg, typename Writer, typename Element,
+          std::size_t Extent>
+constexpr void put_range(Writer& out, conversion const& spec,
+        std::span<Element const, Extent> const range) {
+    constexpr auto separator = std::string_view{Fmt.data + Seg.separator,
+            Seg.separator_size};
+    constexpr auto group = Seg.group ? Seg.group : 1;
+    if constexpr (sizeof(Element) == 1 && (Seg.type == 'x' || Seg.type == 'X')
+            && Seg.flags == zero_pad && Seg.width == 2 && Seg.precision == none) {
+        put_hex_dump(out, range, Seg.type == 'X',
+                separator.empty() ? SIZE_MAX : group, separator);
+    } else {
+        for (std::size_t i = 0; i < range.size(); ++i) {
+            if (i && i % group == 0) out.write(separator.data(), separator.size());
+            auto const value = element_value(range[i]);
+            if constexpr (Seg.type == 'c') {
+                put<'c', Seg.size_of>(out, spec,
+                        value >= 0x20 && value < 0x7f ? value : '.');
+            } else if constexpr (Seg.escape == escaping::json) {
+                put_json_number<Seg.type, Seg.size_of>(out, spec, value);
+            } else {
+                put<Seg.type, Seg.size_of>(out, spec, value);
+            }
+        }
+    }
+}
+
+// The characters that end a run of text that can be copied as it is: any of
+// four characters, and (if `controls`) those below ' '.
+struct stops {
+    char a, b, c, d;
+    bool controls;
+};
+
+// The length of the run at the start of `s` that has no stops, found 32 or 16
+// characters at a time where the target has vector instructions.
+constexpr std::size_t clean_run(char const* const s, std::size_t const n,
+        stops const& stop) noexcept {
+    std::size_t i = 0;
+    if (!std::is_constant_evaluated()) {
+#if defined(__AVX2__)
+        auto const a = _mm256_set1_epi8(stop.a), b = _mm256_set1_epi8(stop.b);
+        auto const c = _mm256_set1_epi8(stop.c), d = _mm256_set1_epi8(stop.d);
+        auto const below = _mm256_set1_epi8(stop.controls ? 0x1f : -1);
+        for (; i + 32 <= n; i += 32) {
+            auto const v = _mm256_loadu_si256(
+                    reinterpret_cast<__m256i const*>(s + i));
+            auto m = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, a), _mm256_cmpeq_epi8(v, b)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, c), _mm256_cmpeq_epi8(v, d)));
+            if (stop.controls)
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi8(
+                        _mm256_max_epu8(v, below), below));
+            if (auto const mask = static_cast<unsigned>(_mm256_movemask_epi8(m)))
+                return i + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+#endif
+#if defined(__SSE2__)
+        auto const a4 = _mm_set1_epi8(stop.a), b4 = _mm_set1_epi8(stop.b);
+        auto const c4 = _mm_set1_epi8(stop.c), d4 = _mm_set1_epi8(stop.d);
+        auto const below4 = _mm_set1_epi8(0x1f);
+        for (; i + 16 <= n; i += 16) {
+            auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(s + i));
+            auto m = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, a4), _mm_cmpeq_epi8(v, b4)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, c4), _mm_cmpeq_epi8(v, d4)));
+            if (stop.controls)
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, below4), below4));
+            if (auto const mask = static_cast<unsigned>(_mm_movemask_epi8(m)))
+                return i + static_cast<std::size_t>(std::countr_zero(mask));
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        for (; i + 16 <= n; i += 16) {
+            auto const v = vld1q_u8(reinterpret_cast<std::uint8_t const*>(s + i));
+            auto m = vorrq_u8(
+                    vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(stop.a))),
+                             vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(stop.b)))),
+                    vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(stop.c))),
+                             vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(stop.d)))));
+            if (stop.controls) m = vorrq_u8(m, vcltq_u8(v, vdupq_n_u8(0x20)));
+            if (vmaxvq_u8(m)) break; // the stop is found below
+        }
+#endif
+    }
+    for (; i < n; ++i) {
+        auto const ch = s[i];
+        if (ch == stop.a || ch == stop.b || ch == stop.c || ch == stop.d
+                || (stop.controls && static_cast<unsigned char>(ch) < 0x20))
+            return i;
+    }
+    return n;
+}
+
+// Writes a string escaped as the content of a JSON or C string literal, or
+// as a CSV field (quoted if it has a comma, a quote or a line break, with
+// quotes doubled). Runs without special characters are copied whole.
+template <escaping Mode, typename Writer>
+constexpr void write_escaped(Writer& out, char const* s, std::size_t n) {
+    constexpr auto stop = Mode == escaping::json ? stops{'"', '\\', '"', '"', true}
+            : Mode == escaping::c ? stops{'"', '\\', '\x7f', '\x7f', true}
+            : stops{'"', '"', '"', '"', false};
+    auto const quoted = Mode == escaping::csv
+            && clean_run(s, n, {',', '"', '\r', '\n', false}) != n;
+    if (quoted) out.write("\"", 1);
+    while (n) {
+        auto const run = clean_run(s, n, stop);
+        out.write(s, run);
+        if (run == n) break;
+        auto const ch = static_cast<unsigned char>(s[run]);
+        s += run + 1;
+        n -= run + 1;
+        char escaped[6] = {'\\', static_cast<char>(ch)};
+        auto size = std::size_t{2};
+        auto const named = std::string_view{"\bb\ff\nn\rr\tt"}
+                .find(static_cast<char>(ch));
+        if (Mode == escaping::csv) {
+            escaped[0] = '"';
+        } else if (named != std::string_view::npos && named % 2 == 0) {
+            escaped[1] = "\bb\ff\nn\rr\tt"[named + 1];
+        } else if (ch < 0x20 || ch == 0x7f) {
+            auto const digits = "0123456789abcdef";
+            if (Mode == escaping::json) {
+                escaped[1] = 'u', escaped[2] = '0', escaped[3] = '0';
+                escaped[4] = digits[ch >> 4], escaped[5] = digits[ch & 15];
+                size = 6;
+            } else { // octal, as a hex escape would take any digits after it
+                escaped[1] = static_cast<char>('0' + (ch >> 6));
+                escaped[2] = static_cast<char>('0' + (ch >> 3 & 7));
+                escaped[3] = static_cast<char>('0' + (ch & 7));
+                size = 4;
+            }
+        }
+        out.write(escaped, size);
+    }
+    if (quoted) out.write("\"", 1);
+}
+
+struct counting_sink {
+    std::size_t count = 0;
+    constexpr void write(char const*, std::size_t const n) noexcept { count += n; }
+};
+
+// %s (or %c) with escaping. The precision limits the characters read, and the
+// width applies to the escaped text.
+template <escaping Mode, typename Writer>
+constexpr void put_escaped(Writer& out, conversion const& spec,
+        char const* const s, std::size_t const n) {
+    auto pad = 0;
+    if (spec.width > 0) {
+        auto counter = counting_sink{};
+        write_escaped<Mode>(counter, s, n);
+        if (counter.count < static_cast<std::size_t>(spec.width))
+            pad = spec.width - static_cast<int>(counter.count);
+    }
+    if (!(spec.flags & left)) out.fill(' ', pad);
+    write_escaped<Mode>(out, s, n);
+    if (spec.flags & left) out.fill(' ', pad);
+}
+
+template <char Type, escaping Mode, typename Writer, typename Value>
+constexpr void put_escaped(Writer& out, conversion const& spec,
+        Value const& value) {
+    if constexpr (Type == 'c') {
+        auto const ch = static_cast<char>(static_cast<unsigned char>(+value));
+        put_escaped<Mode>(out, spec, &ch, 1);
+    } else if constexpr (requires { value.size; }) { // rendered
+        auto n = value.size;
+        if (spec.precision >= 0 && n > static_cast<std::size_t>(spec.precision))
+            n = static_cast<std::size_t>(spec.precision);
+        put_escaped<Mode>(out, spec, value.data, n);
+    } else {
+        char const* s = value;
+        if (!s) s = spec.precision < 0 || spec.precision >= 6 ? "(null)" : "";
+        auto n = std::size_t{};
+        if (spec.precision < 0) {
+            n = std::char_traits<char>::length(s);
+        } else {
+            while (n < static_cast<std::size_t>(spec.precision) && s[n]) ++n;
+        }
+        put_escaped<Mode>(out, spec, s, n);
+    }
+}
+
+// A floating point number in JSON (%{json}g and the like): as it would print,
+// or `null` when it is not finite, as JSON has no form for that.
+template <char Type, length Length, typename Writer, typename Value>
+constexpr void put_json_number(Writer& out, conversion const& spec,
+        Value const value) {
+    if (value != value || value - value != value - value)
+        put_padded(out, spec, "null", 4);
+    else
+        put<Type, Length>(out, spec, value);
+}
+
+template <literal Fmt, segment Seg, typename Writer, typename Args>
+constexpr void step(Writer& out, Args const& args) {
+    if constexpr (Seg.size != 0) out.write(Fmt.data + Seg.text, Seg.size);
+    if constexpr (Seg.type != '\0') {
+        constexpr std::size_t star_width = Seg.width == from_arg;
+        constexpr std::size_t star_precision = Seg.precision == from_arg;
+        auto spec = conversion{Seg.flags, Seg.width, Seg.precision};
+        if constexpr (star_width) {
+            int const width = std::get<Seg.arg>(args);
+            if (width < 0) spec.flags |= left;
+            spec.width = width >= 0 ? width : width == INT_MIN ? INT_MAX : -width;
+        }
+        if constexpr (star_precision) {
+            int const precision = std::get<Seg.arg + star_width>(args);
+            spec.precision = precision >= 0 ? precision : none;
+        }
+        auto const& value = std::get<Seg.arg + star_width + star_precision>(args);
+        if constexpr (Seg.range) {
+            put_range<Fmt, Seg>(out, spec, value);
+        } else if constexpr (Seg.escape == escaping::json
+                && std::is_floating_point_v<std::remove_cvref_t<decltype(value)>>) {
+            put_json_number<Seg.type, Seg.size_of>(out, spec, value);
+        } else if constexpr (Seg.escape != escaping::none) {
+            put_escaped<Seg.type, Seg.escape>(out, spec, value);
+        } else {
+            put<Seg.type, Seg.size_of>(out, spec, value);
+        }
+    }
+}
+
+// Formats the forwarded arguments of a transformed format.
+template <literal Fmt, typename Sink, typename... Args>
+constexpr int render(Sink& sink, Args const&... args) {
+    auto out = writer<Sink>{sink};
+    auto const values = std::tuple<Args const&...>{args...};
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (step<Fmt, plan<Fmt>[I]>(out, values), ...);
+    }(std::make_index_sequence<plan<Fmt>.size()>{});
+    return static_cast<int>(out.count);
+}
+
+template <literal Fmt, unsigned Conversions, typename... Args>
+inline constexpr auto native_fmt = build_fmt_for<Fmt, Conversions, Args...>();
+
+// As `fwd_args`, except that an array of numbers keeps its size (as a span),
+// so that it can be printed as a range, and text that traits<> render is
+// rendered in place (and copied once, to the sink).
+template <typename Arg>
+constexpr auto fwd_native(Arg const& arg) {
+    if constexpr (std::is_array_v<Arg> && concepts::element_range<Arg>) {
+        return std::tuple{std::span<element_of<Arg> const>{arg}};
+    } else if constexpr (concepts::renders<Arg>) {
+        auto text = rendered<traits<Arg>::capacity>{};
+        text.size = static_cast<std::size_t>(
+                traits<Arg>::render(text.data, arg) - text.data);
+        return std::tuple{text};
+    } else {
+        return fwd_args(arg);
+    }
+}
+
+} // namespace native
+} // namespace detail
+
+// Formats to `sink` with the native engine, and returns the number of
+// characters written. `Conversions` may narrow the conversions that are
+// accepted (for example, to keep floating point out of a code path).
+template <literal Fmt, unsigned Conversions = native_conversions,
+          concepts::sink Sink, typename... Args>
+    requires ((Conversions & ~native_conversions) == 0)
+constexpr int format_to(Sink& sink, Args const&... args) {
+    if constexpr (detail::positional<Fmt>) {
+        return detail::with_positions<Fmt>(
+                [&]<literal Seq>(auto const&... args) {
+                    return format_to<Seq, Conversions>(sink, args...);
+                }, args...);
+    } else {
+        return std::apply([&](auto const&... args) {
+                return detail::native::render<detail::native::native_fmt<
+                        Fmt, Conversions, Args...>>(sink, args...);
+            }, std::tuple_cat(detail::native::fwd_native(args)...));
+    }
+}
+
+namespace detail::native {
+
+struct null_sink {
+    constexpr void write(char const*, std::size_t) noexcept {}
+};
+
+} // namespace detail::native
+
+/**
+ * Formats constant values at compile time, and returns the output as a
+ * `literal`. The values are template arguments, so they may be of any
+ * structural type that printx supports: integers, floating-point numbers,
+ * enumerations, pointers to static character arrays, and literals.
+ *
+ *     constexpr auto banner = format_literal<"build %? (%?)", version, build_id>();
+ */
+template <literal Fmt, auto... Values>
+consteval auto format_literal() {
+    constexpr auto size = [] {
+        auto sink = detail::native::null_sink{};
+        return static_cast<std::size_t>(format_to<Fmt>(sink, Values...));
+    }();
+    auto text = literal<size + 1>{};
+    auto sink = buffer_sink{text.data, size + 1};
+    format_to<Fmt>(sink, Values...);
+    return text;
+}
+
+} // namespace printx
+
+#if !defined(ROSTD_PRINTX_FREESTANDING)
+// When every argument is a constant, it can be given as a template argument,
+// and the output is formatted at compile time and written with `fwrite`:
+//
+//     rostd::printf<"build %? (%?)\n", version, build_id>();
+template <printx::literal Fmt, auto Value, auto... Values>
+[[gnu::always_inline]] inline int printf() noexcept {
+    return printx::detail::instrumented<Fmt, decltype(Value), decltype(Values)...>([] {
+        static constexpr auto text = printx::format_literal<Fmt, Value, Values...>();
+        return printx::detail::write_text(stdout, text.data, sizeof text.data - 1);
+    });
+}
+
+template <printx::literal Fmt, auto Value, auto... Values, typename Stream>
+[[gnu::always_inline]] inline int fprintf(Stream const& stream) noexcept {
+    return printx::detail::instrumented<Fmt, decltype(Value), decltype(Values)...>([&] {
+        static constexpr auto text = printx::format_literal<Fmt, Value, Values...>();
+        return printx::detail::write_text(stream, text.data, sizeof text.data - 1);
+    });
+}
+
+namespace printx::detail::native {
+
+// Buffers output, and writes it to a stream.
+class stream_sink {
+public:
+    explicit stream_sink(std::FILE* const stream) noexcept : stream{stream} {}
+
+    void write(char const* p, std::size_t n) noexcept {
+        if (n > sizeof buffer - used) {
+            flush();
+            if (n >= sizeof buffer) {
+                failed |= std::fwrite(p, 1, n, stream) != n;
+                return;
+            }
+        }
+        for (auto const end = p + n; p != end; buffer[used++] = *p++) {}
+    }
+
+    // Returns false if any write failed.
+    bool flush() noexcept {
+        failed |= std::fwrite(buffer, 1, used, stream) != used;
+        used = 0;
+        return !failed;
+    }
+
+private:
+    std::FILE* stream;
+    bool failed = false;
+    std::size_t used = 0;
+    char buffer[256];
+};
+
+// The stream is locked so that a long range cannot be interleaved with
+// another thread's output, as it could not be with `fprintf`.
+template <literal Fmt, typename... Args>
+int print_native(std::FILE* const stream, Args const&... args) noexcept {
+#if defined(_WIN32)
+    _lock_file(stream);
+#else
+    flockfile(stream);
+#endif
+    auto sink = stream_sink{stream};
+    auto const count = format_to<Fmt>(sink, args...);
+    auto const result = sink.flush() ? count : -1;
+#if defined(_WIN32)
+    _unlock_file(stream);
+#else
+    funlockfile(stream);
+#endif
+    return result;
+}
+
+template <literal Fmt, typename... Args>
+int print_native(char* const s, std::size_t const n,
+        Args const&... args) noexcept {
+    auto sink = buffer_sink{s, n};
+    return format_to<Fmt>(sink, args...);
+}
+
+} // namespace printx::detail::native
+#endif
+
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_ENGINE_HPP
@@ -0,0 +1,265 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_FLIGHT_RECORDER_HPP
+#define ROSTD_PRINTX_FLIGHT_RECORDER_HPP
+
+#include <rostd/printx/binary.hpp>
+#include <rostd/printx/packed.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rostd {
+namespace printx {
+
+// A record recovered from a flight recorder file.
+struct flight_record {
+    std::uint32_t thread;    // OS thread identifier of the writer
+    std::uint64_t sequence;  // order of writing, within the writer's lane
+    std::int64_t timestamp;  // nanoseconds (system clock)
+    std::uint64_t id;        // `format_id` of the format
+    std::string text;        // the formatted output
+};
+
+/**
+ * A crash-surviving ring of recent printx records in a memory-mapped file
+ * (such as one in `/dev/shm`). Records are captured with `packed_args` into
+ * fixed-size slots, so writing one costs a clock read, an atomic increment
+ * and a `memcpy`. Because the mapping is shared, everything written survives
+ * the death of the process, and `recover()` (in the same program, or a
+ * separate process built with the same formats) can format the last records
+ * of each thread.
+ *
+ * The ring is divided into lanes, and each thread writes to its own lane
+ * (threads share lanes round-robin when there are more threads than lanes),
+ * so a chatty thread cannot evict the history of the others.
+ *
+ * File layout, all in native byte order:
+ *
+ *     header     := "PXFR" version:u32 lanes:u32 slots:u32 slot_size:u32 (64 bytes)
+ *     heads      := lanes * (next_sequence:u64, padded to 64 bytes)
+ *     slots      := lanes * slots * slot
+ *     slot       := sequence:u64 id:u64 timestamp:i64 thread:u32 size:u32 payload
+ *
+ * A slot's sequence is zero while it is being written, and is published last.
+ */
+class flight_recorder {
+public:
+    struct geometry {
+        std::uint32_t lanes = 16;
+        std::uint32_t slots = 1024;       // per lane
+        std::uint32_t slot_size = 256;    // bytes, including a 32-byte header
+    };
+
+    // Creates (or overwrites) the file at `path`. Recover the contents of a
+    // previous run before reopening it.
+    explicit flight_recorder(char const* const path) noexcept
+        : flight_recorder{path, geometry{}} {}
+
+    flight_recorder(char const* const path, geometry const geom) noexcept {
+        if (geom.lanes == 0 || geom.slots == 0
+                || geom.slot_size < sizeof(slot_header) + 8
+                || geom.slot_size % 8 != 0)
+            return;
+        auto const fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return;
+        auto const size = file_size(geom);
+        if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            auto const p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED) {
+                base = static_cast<std::byte*>(p);
+                length = size;
+                layout = geom;
+                auto const h = header{{'P', 'X', 'F', 'R'}, version,
+                        geom.lanes, geom.slots, geom.slot_size, {}};
+                std::memcpy(base, &h, sizeof h);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~flight_recorder() {
+        if (base) ::munmap(base, length);
+    }
+
+    flight_recorder(flight_recorder const&) = delete;
+    flight_recorder& operator=(flight_recorder const&) = delete;
+
+    explicit operator bool() const noexcept { return base != nullptr; }
+
+    // Records a message. Arguments that do not fit in a slot are dropped, and
+    // the record is recovered as its format string followed by a note.
+    template <literal Fmt, typename... Args>
+    void record(Args const&... args) noexcept {
+        if (!base) return;
+        using entry = detail::binary::catalog_entry<Fmt,
+                std::remove_cvref_t<Args>...>;
+        (void)&entry::linked;
+        auto const lane = thread_token() % layout.lanes;
+        auto const sequence = heads()[lane * head_stride].fetch_add(1,
+                std::memory_order_relaxed) + 1;
+        auto const slot = base + slots_offset(layout)
+                + (std::size_t{lane} * layout.slots
+                   + (sequence - 1) % layout.slots) * layout.slot_size;
+        auto& h = *reinterpret_cast<slot_header*>(slot);
+        h.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        using namespace std::chrono;
+        h.id = entry::format.id;
+        h.timestamp = duration_cast<nanoseconds>(
+                system_clock::now().time_since_epoch()).count();
+        h.thread = thread_id();
+        using pack = packed_args<std::remove_cvref_t<Args>...>;
+        auto const size = pack::pack(
+                {slot + sizeof h, layout.slot_size - sizeof h}, args...);
+        h.size = size != 0 || pack::size(args...) == 0
+                ? static_cast<std::uint32_t>(size) : truncated;
+        h.sequence.store(sequence, std::memory_order_release);
+    }
+
+    // Reads the file at `path` and formats the last `per_thread` records of
+    // each thread, ordered by time. Returns nothing if the file is not a
+    // flight recorder.
+    static std::vector<flight_record> recover(char const* const path,
+            std::size_t const per_thread = ~std::size_t{}) {
+        auto records = std::vector<flight_record>{};
+        auto const fd = ::open(path, O_RDONLY);
+        if (fd < 0) return records;
+        struct ::stat st = {};
+        auto h = header{};
+        if (::fstat(fd, &st) != 0 || ::pread(fd, &h, sizeof h, 0) != sizeof h
+                || std::memcmp(h.magic, "PXFR", 4) != 0 || h.version != version
+                || static_cast<std::size_t>(st.st_size)
+                        != file_size({h.lanes, h.slots, h.slot_size})) {
+            ::close(fd);
+            return records;
+        }
+        auto const geom = geometry{h.lanes, h.slots, h.slot_size};
+        auto const size = static_cast<std::size_t>(st.st_size);
+        auto const p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return records;
+
+        auto by_thread = std::map<std::uint32_t, std::vector<flight_record>>{};
+        auto const slots = static_cast<std::byte const*>(p) + slots_offset(geom);
+        for (std::size_t i = 0; i < std::size_t{geom.lanes} * geom.slots; ++i) {
+            auto const slot = slots + i * geom.slot_size;
+            auto const& sh = *reinterpret_cast<slot_header const*>(slot);
+            auto const sequence = sh.sequence.load(std::memory_order_acquire);
+            if (sequence == 0) continue;
+            auto r = flight_record{sh.thread, sequence, sh.timestamp, sh.id, {}};
+            auto const format = find_binary_format(sh.id);
+            if (!format) {
+                char buf[sizeof "<unknown format >" + 16];
+                rostd::snprintf<"<unknown format %016x>">(buf, sizeof buf, sh.id);
+                r.text = buf;
+            } else if (sh.size == truncated
+                    || sh.size > geom.slot_size - sizeof sh) {
+                r.text = std::string{format->format} + " <arguments truncated>";
+            } else if (!format->format_packed(slot + sizeof sh, r.text)) {
+                continue;
+            }
+            by_thread[r.thread].push_back(std::move(r));
+        }
+        ::munmap(p, size);
+
+        auto const earlier = [](flight_record const& a, flight_record const& b) {
+            return a.timestamp != b.timestamp ? a.timestamp < b.timestamp
+                                              : a.sequence < b.sequence;
+        };
+        for (auto& [thread, list] : by_thread) {
+            std::sort(list.begin(), list.end(), earlier);
+            auto const keep = std::min(per_thread, list.size());
+            std::move(list.end() - keep, list.end(), std::back_inserter(records));
+        }
+        std::sort(records.begin(), records.end(), earlier);
+        return records;
+    }
+
+private:
+    static constexpr std::uint32_t version = 1;
+    static constexpr std::uint32_t truncated = ~std::uint32_t{};
+    static constexpr std::size_t head_stride = 64 / sizeof(std::uint64_t);
+
+    struct header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t lanes;
+        std::uint32_t slots;
+        std::uint32_t slot_size;
+        char reserved[44];
+    };
+    static_assert(sizeof(header) == 64);
+
+    struct slot_header {
+        std::atomic<std::uint64_t> sequence;
+        std::uint64_t id;
+        std::int64_t timestamp;
+        std::uint32_t thread;
+        std::uint32_t size;
+    };
+    static_assert(sizeof(slot_header) == 32);
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    static constexpr std::size_t slots_offset(geometry const& g) noexcept {
+        return sizeof(header) + std::size_t{g.lanes} * 64;
+    }
+
+    static constexpr std::size_t file_size(geometry const& g) noexcept {
+        return slots_offset(g)
+                + std::size_t{g.lanes} * g.slots * g.slot_size;
+    }
+
+    std::atomic<std::uint64_t>* heads() const noexcept {
+        return reinterpret_cast<std::atomic<std::uint64_t>*>(
+                base + sizeof(header));
+    }
+
+    // A small number unique to each thread, used to pick its lane.
+    static std::uint32_t thread_token() noexcept {
+        static constinit std::atomic<std::uint32_t> next{0};
+        thread_local auto const token =
+                next.fetch_add(1, std::memory_order_relaxed);
+        return token;
+    }
+
+    static std::uint32_t thread_id() noexcept {
+        thread_local auto const id = [] {
+#if defined(__linux__)
+            return static_cast<std::uint32_t>(::gettid());
+#else
+            return static_cast<std::uint32_t>(
+                    std::hash<std::thread::id>{}(std::this_thread::get_id()));
+#endif
+        }();
+        return id;
+    }
+
+    std::byte* base = nullptr;
+    std::size_t length = 0;
+    geometry layout = {};
+};
+
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_FLIGHT_RECORDER_HPP
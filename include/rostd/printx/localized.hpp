@@ -0,0 +1,154 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_LOCALIZED_HPP
+#define ROSTD_PRINTX_LOCALIZED_HPP
+
+#include <rostd/printx.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+
+namespace rostd {
+namespace printx {
+
+// The active locale: an index into the formats of every `localized` message.
+// A message without a format for it uses its first format.
+inline std::atomic<std::size_t> active_locale{0};
+
+inline void set_locale(std::size_t const locale) noexcept {
+    active_locale.store(locale, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+template <literal Fmt, typename... Args>
+inline constexpr auto built_fmt = build_fmt<Fmt, Args...>();
+
+// Whether a format consumes `Count` arguments in the order they are given.
+template <literal Fmt, std::size_t Count>
+consteval bool in_order() noexcept {
+    if constexpr (positional<Fmt>) {
+        check_positions<Fmt, Count>();
+        auto const& order = argument_order<Fmt>;
+        if (order.size() != Count) return false;
+        for (std::size_t i = 0; i < Count; ++i)
+            if (order[i] != i) return false;
+    }
+    return true;
+}
+
+// Calls `print(format, forwarded...)` with the transformed format of `Fmt`,
+// and the arguments in the order that it consumes them.
+template <literal Fmt, typename Print, typename... Args>
+int print_transformed(Print const& print, Args const&... args) {
+    if constexpr (positional<Fmt>) {
+        return with_positions<Fmt>([&]<literal Seq>(auto const&... args) {
+                return print_transformed<Seq>(print, args...);
+            }, args...);
+    } else {
+        return invoke([&](auto const&... args) {
+                return print(built_fmt<Fmt, Args...>.data, args...);
+            }, args...);
+    }
+}
+
+} // namespace detail
+
+#if defined(__GNUC__) || defined(__clang__)
+    // The formats are chosen at run time, but each one has been validated.
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    #pragma GCC diagnostic ignored "-Wformat-security"
+#endif
+
+/**
+ * A message with a format for each locale, such as a message catalog entry
+ * and its translations. Every format is checked against the arguments of each
+ * call, and transformed, at compile time; the format for `active_locale` is
+ * then chosen with a single indexed load:
+ *
+ *     using files_in = localized<"%? files in %?\n", "%2$? : %1$? fichiers\n">;
+ *     files_in::printf(count, dir);
+ *
+ * When every format consumes the arguments in the order they are given, the
+ * formats are kept in a table of strings, and there is one `printf` call for
+ * all of them. Otherwise each format has its own call, with the arguments
+ * reordered at compile time, and the table holds those calls.
+ */
+template <literal... Fmts>
+    requires (sizeof...(Fmts) > 0)
+struct localized {
+    static constexpr std::size_t locales = sizeof...(Fmts);
+
+    // Calls `print(format, forwarded...)`, as the `printf`-family function
+    // `print` would be called in "printx form".
+    template <typename... Args, typename Print>
+    static int call(Print const& print, Args const&... args) {
+        auto const locale = active_locale.load(std::memory_order_relaxed);
+        auto const i = locale < locales ? locale : 0;
+        if constexpr ((detail::in_order<Fmts, sizeof...(Args)>() && ...)) {
+            static constexpr char const* formats[] = {detail::built_fmt<
+                    detail::sequential_fmt<Fmts>, Args...>.data...};
+            return invoke([&](auto const&... args) {
+                    return print(formats[i], args...);
+                }, args...);
+        } else {
+            using thunk = int (*)(Print const&, Args const&...);
+            static constexpr thunk thunks[] = {
+                    &detail::print_transformed<Fmts, Print, Args...>...};
+            return thunks[i](print, args...);
+        }
+    }
+
+    template <typename... Args>
+    static int printf(Args const&... args) noexcept {
+        return call([](char const* const format, auto const&... args) {
+                return std::printf(format, args...);
+            }, args...);
+    }
+
+    template <typename Stream, typename... Args>
+    static int fprintf(Stream const& stream, Args const&... args) noexcept {
+        return call([&](char const* const format, auto const&... args) {
+                return std::fprintf(stream, format, args...);
+            }, args...);
+    }
+
+    template <typename... Args>
+    static int snprintf(char* s, std::size_t n, Args const&... args) noexcept {
+        return call([&](char const* const format, auto const&... args) {
+                return std::snprintf(s, n, format, args...);
+            }, args...);
+    }
+
+    template <typename Buffer, typename... Args>
+        requires requires(Buffer b) { std::data(b); std::size(b); }
+    static int sprintf(Buffer&& buffer, Args const&... args) noexcept {
+        return call([&](char const* const format, auto const&... args) {
+                return std::snprintf(std::data(buffer), std::size(buffer),
+                        format, args...);
+            }, args...);
+    }
+};
+
+#if defined(__GNUC__) || defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_LOCALIZED_HPP
@@ -0,0 +1,238 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_NET_HPP
+#define ROSTD_PRINTX_NET_HPP
+
+#include <rostd/printx/engine.hpp>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace rostd {
+namespace printx {
+
+// A 6-byte hardware address, printed as "00:1a:2b:3c:4d:5e".
+struct mac_address {
+    std::uint8_t bytes[6];
+};
+
+// A 16-byte UUID, printed as "123e4567-e89b-12d3-a456-426614174000".
+struct uuid {
+    std::uint8_t bytes[16];
+};
+
+namespace detail {
+namespace net {
+
+constexpr char* put_octet(char* out, unsigned value) noexcept {
+    if (value >= 100) {
+        *out++ = static_cast<char>('0' + value / 100);
+        value %= 100;
+        *out++ = static_cast<char>('0' + value / 10);
+    } else if (value >= 10) {
+        *out++ = static_cast<char>('0' + value / 10);
+    }
+    *out++ = static_cast<char>('0' + value % 10);
+    return out;
+}
+
+constexpr char* put_decimal(char* out, std::uint32_t value) noexcept {
+    char digits[10];
+    auto n = 0;
+    do { digits[n++] = static_cast<char>('0' + value % 10); } while (value /= 10);
+    while (n) *out++ = digits[--n];
+    return out;
+}
+
+// Dotted decimal, as "192.0.2.1".
+constexpr char* put_ipv4(char* out, std::uint8_t const* const bytes) noexcept {
+    for (auto i = 0; i < 4; ++i) {
+        if (i) *out++ = '.';
+        out = put_octet(out, bytes[i]);
+    }
+    return out;
+}
+
+// A 16-bit group in lowercase hex, without leading zeros.
+constexpr char* put_group(char* out, unsigned const group) noexcept {
+    auto shift = 12;
+    while (shift && !(group >> shift)) shift -= 4;
+    for (; shift >= 0; shift -= 4) *out++ = "0123456789abcdef"[(group >> shift) & 15];
+    return out;
+}
+
+// The canonical text of an IPv6 address (RFC 5952): groups without leading
+// zeros, the longest run of two or more zero groups (the first, on a tie)
+// as "::", and IPv4-mapped addresses as "::ffff:192.0.2.1".
+constexpr char* put_ipv6(char* out, std::uint8_t const* const bytes) noexcept {
+    unsigned groups[8] = {};
+    for (auto i = 0; i < 8; ++i) groups[i] = bytes[2 * i] << 8 | bytes[2 * i + 1];
+    auto const mapped = !(groups[0] | groups[1] | groups[2] | groups[3]
+            | groups[4]) && groups[5] == 0xffff;
+    auto const last = mapped ? 6 : 8;
+    auto first = -1, run = 1;
+    for (auto i = 0; i < last;) {
+        if (groups[i]) { ++i; continue; }
+        auto j = i;
+        while (j < last && !groups[j]) ++j;
+        if (j - i > run) first = i, run = j - i;
+        i = j;
+    }
+    for (auto i = 0; i < last; ++i) {
+        if (first >= 0 && i >= first && i < first + run) {
+            if (i == first) *out++ = ':';
+            continue;
+        }
+        if (i) *out++ = ':';
+        out = put_group(out, groups[i]);
+    }
+    if (first >= 0 && first + run == last) *out++ = ':';
+    if (mapped) *out++ = ':', out = put_ipv4(out, bytes + 12);
+    return out;
+}
+
+constexpr std::uint16_t port_of(std::uint16_t const port) noexcept {
+    auto const bytes = std::bit_cast<std::array<std::uint8_t, 2>>(port);
+    return static_cast<std::uint16_t>(bytes[0] << 8 | bytes[1]);
+}
+
+inline char* put_address(char* out, sockaddr_in const& address) noexcept {
+    auto const bytes = std::bit_cast<std::array<std::uint8_t, 4>>(
+            address.sin_addr);
+    out = put_ipv4(out, bytes.data());
+    *out++ = ':';
+    return put_decimal(out, port_of(address.sin_port));
+}
+
+// As "[2001:db8::1]:443", with the scope of a link-local address as
+// "[fe80::1%2]:22".
+inline char* put_address(char* out, sockaddr_in6 const& address) noexcept {
+    *out++ = '[';
+    out = put_ipv6(out, address.sin6_addr.s6_addr);
+    if (address.sin6_scope_id) {
+        *out++ = '%';
+        out = put_decimal(out, address.sin6_scope_id);
+    }
+    *out++ = ']';
+    *out++ = ':';
+    return put_decimal(out, port_of(address.sin6_port));
+}
+
+} // namespace net
+
+template <>
+struct traits<in_addr> {
+    static constexpr std::size_t capacity = 16;
+    static char* render(char* out, in_addr const& address) noexcept {
+        auto const bytes = std::bit_cast<std::array<std::uint8_t, 4>>(address);
+        return net::put_ipv4(out, bytes.data());
+    }
+    static constexpr auto spec = "s";
+};
+
+template <>
+struct traits<in6_addr> {
+    static constexpr std::size_t capacity = 48;
+    static char* render(char* out, in6_addr const& address) noexcept {
+        return net::put_ipv6(out, address.s6_addr);
+    }
+    static constexpr auto spec = "s";
+};
+
+template <>
+struct traits<sockaddr_in> {
+    static constexpr std::size_t capacity = 24;
+    static char* render(char* out, sockaddr_in const& address) noexcept {
+        return net::put_address(out, address);
+    }
+    static constexpr auto spec = "s";
+};
+
+template <>
+struct traits<sockaddr_in6> {
+    static constexpr std::size_t capacity = 72;
+    static char* render(char* out, sockaddr_in6 const& address) noexcept {
+        return net::put_address(out, address);
+    }
+    static constexpr auto spec = "s";
+};
+
+// Either kind of address (as above), or the family of any other.
+template <>
+struct traits<sockaddr_storage> {
+    static constexpr std::size_t capacity = 72;
+    static char* render(char* out, sockaddr_storage const& storage) noexcept {
+        if (storage.ss_family == AF_INET) {
+            auto address = sockaddr_in{};
+            std::memcpy(&address, &storage, sizeof address);
+            return net::put_address(out, address);
+        }
+        if (storage.ss_family == AF_INET6) {
+            auto address = sockaddr_in6{};
+            std::memcpy(&address, &storage, sizeof address);
+            return net::put_address(out, address);
+        }
+        constexpr char family[] = "(family ";
+        std::memcpy(out, family, sizeof family - 1);
+        out = net::put_decimal(out + sizeof family - 1, storage.ss_family);
+        *out++ = ')';
+        return out;
+    }
+    static constexpr auto spec = "s";
+};
+
+template <>
+struct traits<mac_address> {
+    static constexpr std::size_t capacity = 18;
+    static constexpr char* render(char* out, mac_address const& mac) noexcept {
+        char hex[12] = {};
+        native::hex_encode(hex, mac.bytes, 6, false);
+        for (auto i = 0; i < 6; ++i) {
+            if (i) *out++ = ':';
+            *out++ = hex[2 * i];
+            *out++ = hex[2 * i + 1];
+        }
+        return out;
+    }
+    static constexpr auto spec = "s";
+};
+
+// The 32 digits are encoded with one vector where the target has them, and
+// then split 8-4-4-4-12.
+template <>
+struct traits<uuid> {
+    static constexpr std::size_t capacity = 37;
+    static constexpr char* render(char* out, uuid const& id) noexcept {
+        char hex[32] = {};
+        native::hex_encode(hex, id.bytes, 16, false);
+        auto in = hex;
+        for (auto const size : {8, 4, 4, 4, 12}) {
+            if (in != hex) *out++ = '-';
+            for (auto i = 0; i < size; ++i) *out++ = *in++;
+        }
+        return out;
+    }
+    static constexpr auto spec = "s";
+};
+
+} // namespace detail
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_NET_HPP
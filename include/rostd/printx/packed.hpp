@@ -0,0 +1,276 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_PACKED_HPP
+#define ROSTD_PRINTX_PACKED_HPP
+
+#include <rostd/printx.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace rostd {
+namespace printx {
+
+// How `packed_args` captures pointers to `char` (that is, `%s` arguments that
+// are not owned by a string object).
+enum class char_ptr {
+    copy,      // the string contents are copied (safe, but costs the copy)
+    reference  // only the pointer is kept (the string must outlive the pack)
+};
+
+namespace detail {
+namespace packing {
+
+// Strings are stored inline as a 32-bit length followed by their contents.
+// A null `char const*` is stored with this length and restored as null.
+inline constexpr auto null_string = ~std::uint32_t{};
+
+template <typename Value>
+inline void put(std::byte*& out, Value const& value) noexcept {
+    std::memcpy(out, &value, sizeof value);
+    out += sizeof value;
+}
+
+template <typename Value>
+inline Value get(std::byte const*& in) noexcept {
+    auto value = Value{};
+    std::memcpy(&value, in, sizeof value);
+    in += sizeof value;
+    return value;
+}
+
+inline void put_string(std::byte*& out, char const* str, std::size_t size,
+        bool const terminate) noexcept {
+    put(out, static_cast<std::uint32_t>(size));
+    std::memcpy(out, str, size);
+    out += size;
+    if (terminate) *out++ = std::byte{};
+}
+
+inline char const* get_string(std::byte const*& in, std::size_t& size,
+        bool const terminated) noexcept {
+    auto const length = get<std::uint32_t>(in);
+    if (length == null_string) return (size = 0), nullptr;
+    auto const str = reinterpret_cast<char const*>(in);
+    in += (size = length) + terminated;
+    return str;
+}
+
+template <typename Arg>
+concept c_str_type = requires(Arg a) { a.c_str(); };
+
+template <typename Arg>
+concept counted_chars = !c_str_type<Arg>
+        && requires(Arg a) { std::data(a); std::size(a); }
+        && concepts::container_of_char<Arg>;
+
+template <typename Arg>
+concept char_pointer = std::same_as<std::decay_t<Arg>, char*>
+        || std::same_as<std::decay_t<Arg>, char const*>;
+
+// The capture of a single argument. The general case stores the forwarded
+// values as raw bytes; strings are stored by value.
+template <char_ptr Policy, typename Arg>
+struct codec {
+    // A range is forwarded as a span of its elements, which would outlive
+    // them. (Arrays are captured as pointers, for `%p`.)
+    static_assert(!concepts::element_range<Arg> || std::is_array_v<Arg>,
+            "ranges cannot be captured (deferred formats do not print them)");
+
+    using forwarded = decltype(fwd_args(std::declval<Arg const&>()));
+
+    static std::size_t size(Arg const&) noexcept {
+        return []<std::size_t... I>(std::index_sequence<I...>) {
+            return (std::size_t{} + ... +
+                    sizeof(std::tuple_element_t<I, forwarded>));
+        }(std::make_index_sequence<std::tuple_size_v<forwarded>>{});
+    }
+    static void pack(std::byte*& out, Arg const& arg) noexcept {
+        std::apply([&](auto const&... values) {
+            static_assert((std::is_trivially_copyable_v<
+                    std::remove_cvref_t<decltype(values)>> && ...),
+                    "forwarded arguments must be trivially copyable");
+            (put(out, values), ...);
+        }, fwd_args(arg));
+    }
+    static forwarded unpack(std::byte const*& in) noexcept {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            // Braced initialization guarantees left-to-right evaluation.
+            return forwarded{get<std::tuple_element_t<I, forwarded>>(in)...};
+        }(std::make_index_sequence<std::tuple_size_v<forwarded>>{});
+    }
+};
+
+// `std::string`, `std::filesystem::path`: forwarded as `char const*`.
+template <char_ptr Policy, c_str_type Arg>
+struct codec<Policy, Arg> {
+    static std::size_t size(Arg const& arg) noexcept {
+        return sizeof(std::uint32_t) + std::strlen(arg.c_str()) + 1;
+    }
+    static void pack(std::byte*& out, Arg const& arg) noexcept {
+        auto const str = arg.c_str();
+        put_string(out, str, std::strlen(str), true);
+    }
+    static std::tuple<char const*> unpack(std::byte const*& in) noexcept {
+        auto size = std::size_t{};
+        return {get_string(in, size, true)};
+    }
+};
+
+// `std::string_view`, `std::vector<char>`: forwarded as (`int`, `char const*`).
+template <char_ptr Policy, counted_chars Arg>
+struct codec<Policy, Arg> {
+    static std::size_t size(Arg const& arg) noexcept {
+        return sizeof(std::uint32_t) + std::size(arg);
+    }
+    static void pack(std::byte*& out, Arg const& arg) noexcept {
+        put_string(out, std::data(arg), std::size(arg), false);
+    }
+    static std::tuple<int, char const*> unpack(std::byte const*& in) noexcept {
+        auto size = std::size_t{};
+        auto const str = get_string(in, size, false);
+        return {static_cast<int>(size), str};
+    }
+};
+
+// Character arrays (including string literals) and pointers to `char`.
+template <char_ptr Policy, char_pointer Arg>
+    requires (Policy == char_ptr::copy || std::is_array_v<Arg>)
+struct codec<Policy, Arg> {
+    static std::size_t size(char const* const str) noexcept {
+        return sizeof(std::uint32_t) + (str ? std::strlen(str) + 1 : 0);
+    }
+    static void pack(std::byte*& out, char const* const str) noexcept {
+        if (str) put_string(out, str, std::strlen(str), true);
+        else put(out, null_string);
+    }
+    static std::tuple<char const*> unpack(std::byte const*& in) noexcept {
+        auto size = std::size_t{};
+        return {get_string(in, size, true)};
+    }
+};
+
+// Types that traits<> render (such as addresses and 128-bit integers): the
+// text is rendered into the pack, and stored as a string, rather than as the
+// pointer to the thread-local slot that `fwd_args` renders it into.
+template <char_ptr Policy, concepts::renders Arg>
+struct codec<Policy, Arg> {
+    static std::size_t size(Arg const& arg) noexcept {
+        char text[traits<Arg>::capacity];
+        return sizeof(std::uint32_t) + (traits<Arg>::render(text, arg) - text) + 1;
+    }
+    static void pack(std::byte*& out, Arg const& arg) noexcept {
+        auto const text = reinterpret_cast<char*>(out + sizeof(std::uint32_t));
+        auto const end = traits<Arg>::render(text, arg);
+        put(out, static_cast<std::uint32_t>(end - text));
+        *end = '\0';
+        out = reinterpret_cast<std::byte*>(end + 1);
+    }
+    static std::tuple<char const*> unpack(std::byte const*& in) noexcept {
+        auto size = std::size_t{};
+        return {get_string(in, size, true)};
+    }
+};
+
+// Types with a sub-format: each member is captured by its own codec.
+template <char_ptr Policy, concepts::composite Arg>
+struct codec<Policy, Arg> {
+    template <typename Member>
+    using member_codec = codec<Policy, std::remove_cvref_t<Member>>;
+
+    static std::size_t size(Arg const& arg) noexcept {
+        return std::apply([](auto const&... members) {
+                return (std::size_t{} + ...
+                        + member_codec<decltype(members)>::size(members));
+            }, traits<Arg>::fwd_args(arg));
+    }
+    static void pack(std::byte*& out, Arg const& arg) noexcept {
+        std::apply([&](auto const&... members) {
+                (member_codec<decltype(members)>::pack(out, members), ...);
+            }, traits<Arg>::fwd_args(arg));
+    }
+    static auto unpack(std::byte const*& in) noexcept {
+        return [&]<typename... Members>(std::type_identity<std::tuple<Members...>>) {
+            // Braced initialization guarantees left-to-right evaluation.
+            auto const parts = std::tuple<
+                    decltype(member_codec<Members>::unpack(in))...>{
+                    member_codec<Members>::unpack(in)...};
+            return std::apply([](auto const&... parts) {
+                    return std::tuple_cat(parts...);
+                }, parts);
+        }(std::type_identity<members_of<Arg>>{});
+    }
+};
+
+} // namespace packing
+} // namespace detail
+
+/**
+ * Captures the arguments of a printx call by value, as the forwarded values
+ * that would be passed to the underlying `printf`-family function, in a
+ * compact, trivially copyable byte layout that can be formatted later (and
+ * elsewhere, such as on another thread). Scalars are stored as raw bytes,
+ * unaligned. The contents of strings are stored inline, so the pack has no
+ * references to the original arguments (except for pointers to `char` under
+ * `char_ptr::reference`).
+ *
+ * The layout is determined by `Args` alone, so a pack can only be read back
+ * by the same `basic_packed_args` type.
+ */
+template <char_ptr Policy, typename... Args>
+class basic_packed_args {
+public:
+    // The number of bytes needed to capture `args`.
+    static std::size_t size(Args const&... args) noexcept {
+        return (std::size_t{} + ... + codec<Args>::size(args));
+    }
+
+    // Captures `args` into `out`. Returns the number of bytes used, or zero
+    // if `out` is too small.
+    static std::size_t pack(std::span<std::byte> const out,
+            Args const&... args) noexcept {
+        auto const needed = size(args...);
+        if (needed > out.size()) return 0;
+        [[maybe_unused]] auto p = out.data();
+        (codec<Args>::pack(p, args), ...);
+        return needed;
+    }
+
+    // Calls `call` with the forwarded arguments captured in `in`. Strings
+    // refer to the contents of `in`, which must outlive the call.
+    template <typename Function>
+    static decltype(auto) apply(std::byte const* in, Function const& call) {
+        // Braced initialization guarantees left-to-right evaluation.
+        auto const values = std::tuple<decltype(codec<Args>::unpack(in))...>{
+                codec<Args>::unpack(in)...};
+        return std::apply([&](auto const&... forwarded) {
+            return std::apply(call, std::tuple_cat(forwarded...));
+        }, values);
+    }
+
+private:
+    template <typename Arg>
+    using codec = detail::packing::codec<Policy, std::remove_cvref_t<Arg>>;
+};
+
+template <typename... Args>
+using packed_args = basic_packed_args<char_ptr::copy, Args...>;
+
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_PACKED_HPP
@@ -0,0 +1,234 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_PRINTX_RUNTIME_HPP
+#define ROSTD_PRINTX_RUNTIME_HPP
+
+#include <rostd/printx.hpp>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rostd {
+namespace printx {
+namespace detail::native {
+
+// The length sub-specifier that the transformer gives a forwarded value.
+template <typename Value>
+inline constexpr auto length_of = [] {
+    auto spec = std::string_view{traits<Value>::spec};
+    spec.remove_suffix(1);
+    return spec == "hh" ? length::hh : spec == "h" ? length::h
+         : spec == "l" ? length::l : spec == "ll" ? length::ll
+         : spec == "L" ? length::L : length::none;
+}();
+
+// Calls `f` with the forwarded value at index `i`.
+template <typename Values, typename Function>
+constexpr void visit(Values const& values, std::size_t const i,
+        Function const& f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (void)((I == i ? (f(std::get<I>(values)), true) : false) || ...);
+    }(std::make_index_sequence<std::tuple_size_v<Values>>{});
+}
+
+// As `put`, with the conversion chosen at run time from those that the
+// transformer allows for the type of `value`.
+template <typename Writer, typename Value>
+constexpr void put_dynamic(Writer& out, char const type,
+        conversion const& spec, Value const& value) {
+    constexpr auto L = length_of<Value>;
+    if constexpr (std::is_floating_point_v<Value>) {
+#if ROSTD_PRINTX_NATIVE_FLOAT
+        switch (type) {
+        case 'f': return put<'f', L>(out, spec, value);
+        case 'F': return put<'F', L>(out, spec, value);
+        case 'e': return put<'e', L>(out, spec, value);
+        case 'E': return put<'E', L>(out, spec, value);
+        case 'g': return put<'g', L>(out, spec, value);
+        case 'G': return put<'G', L>(out, spec, value);
+        case 'a': return put<'a', L>(out, spec, value);
+        case 'A': return put<'A', L>(out, spec, value);
+        }
+#endif
+    } else if constexpr (std::is_integral_v<Value>) {
+        switch (type) {
+        case 'd': return put<'d', L>(out, spec, value);
+        case 'i': return put<'i', L>(out, spec, value);
+        case 'u': return put<'u', L>(out, spec, value);
+        case 'o': return put<'o', L>(out, spec, value);
+        case 'x': return put<'x', L>(out, spec, value);
+        case 'X': return put<'X', L>(out, spec, value);
+        case 'c': return put<'c', L>(out, spec, value);
+        }
+    } else if constexpr (std::is_pointer_v<Value>
+            || std::is_null_pointer_v<Value>) {
+        if constexpr (std::is_convertible_v<Value, char const*>)
+            if (type == 's') return put<'s', L>(out, spec, value);
+        if (type == 'p') return put<'p', L>(out, spec, value);
+    }
+}
+
+// Formats forwarded arguments with a plan parsed at run time.
+template <typename Sink, typename... Values>
+int render_dynamic(Sink& sink, char const* const text,
+        std::vector<segment> const& plan, Values const&... values) {
+    auto out = writer<Sink>{sink};
+    auto const refs = std::tuple<Values const&...>{values...};
+    auto const int_at = [&](std::size_t const i) {
+        auto n = 0;
+        visit(refs, i, [&]<typename Value>(Value const& v) {
+            if constexpr (std::is_integral_v<Value>) n = static_cast<int>(v);
+        });
+        return n;
+    };
+    for (auto const& seg : plan) {
+        out.write(text + seg.text, seg.size);
+        if (seg.type == '\0') continue;
+        auto spec = conversion{seg.flags, seg.width, seg.precision};
+        auto arg = seg.arg;
+        if (seg.width == from_arg) {
+            auto const width = int_at(arg++);
+            if (width < 0) spec.flags |= left;
+            spec.width = width >= 0 ? width : width == INT_MIN ? INT_MAX : -width;
+        }
+        if (seg.precision == from_arg) {
+            auto const precision = int_at(arg++);
+            spec.precision = precision >= 0 ? precision : none;
+        }
+        visit(refs, arg, [&](auto const& value) {
+            put_dynamic(out, seg.type, spec, value);
+        });
+    }
+    return static_cast<int>(out.count);
+}
+
+} // namespace detail::native
+
+/**
+ * A format that is only known at run time (from a configuration file, or a
+ * server), checked against `Args...` by the same rules as a literal format.
+ * Construction validates and transforms the format, and compiles it into a
+ * plan of text segments and conversions; formatting then runs the plan on
+ * the native engine, with no parsing.
+ *
+ *     auto const greeting = runtime_format<std::string_view, int>{config.text};
+ *     if (!greeting) log("bad greeting format: %s", greeting.error());
+ *     greeting.printf(name, count);
+ *
+ * A format that is rejected produces no output, and its functions return -1
+ * (with `errno` set to `EINVAL`). Because the format comes from outside the
+ * program, `%n` is not accepted. `cached` keeps the compiled formats of
+ * recently used strings, so that a format can be given as a string on every
+ * call.
+ */
+template <typename... Args>
+class runtime_format {
+public:
+    // The conversions accepted in a format.
+    static constexpr unsigned conversions = native_conversions
+            & ~(detail::position_conversions | detail::range_conversions
+                | detail::escape_conversions);
+
+    explicit runtime_format(std::string_view const format) : source{format} {
+        auto src = source.c_str();
+        auto counter = detail::counting_transformer{};
+        counter.transform<Args...>(src);
+        transformed.resize(counter.count);
+        src = source.c_str();
+        st = detail::appending_transformer{transformed.data(), conversions}
+                .transform<Args...>(src);
+        if (st != detail::status::correct) {
+            offset = static_cast<std::size_t>(src - source.c_str());
+            return;
+        }
+        plan.resize(detail::native::count_segments(transformed.c_str()));
+        detail::native::parse_plan(transformed.c_str(), plan.data());
+    }
+
+    explicit operator bool() const noexcept
+            { return st == detail::status::correct; }
+
+    // Why the format was rejected, or null if it was not.
+    char const* error() const noexcept { return detail::check_error(st); }
+
+    // Where in the format the problem was found.
+    std::size_t error_offset() const noexcept { return offset; }
+
+    std::string_view format() const noexcept { return source; }
+
+    // The equivalent `printf` format, for a format that was accepted.
+    std::string_view transformed_format() const noexcept { return transformed; }
+
+    template <concepts::sink Sink>
+    int format_to(Sink& sink, Args const&... args) const {
+        if (!*this) return (errno = EINVAL), -1;
+        return invoke([&](auto const&... args) {
+                return detail::native::render_dynamic(sink, transformed.c_str(),
+                        plan, args...);
+            }, args...);
+    }
+
+    int snprintf(char* const s, std::size_t const n, Args const&... args) const {
+        auto sink = buffer_sink{s, n};
+        return format_to(sink, args...);
+    }
+
+    int fprintf(std::FILE* const stream, Args const&... args) const {
+        auto sink = detail::native::stream_sink{stream};
+        auto const count = format_to(sink, args...);
+        return sink.flush() ? count : -1;
+    }
+
+    int printf(Args const&... args) const { return fprintf(stdout, args...); }
+
+    // The compiled form of `format`, compiled on first use by the calling
+    // thread and kept in a small cache keyed by the address of the string.
+    // A string with the same address but different contents (a buffer that
+    // has been reused) is compiled again. Another format may evict it from
+    // the cache, so it is shared: what is returned stays valid while held.
+    static std::shared_ptr<runtime_format const> cached(
+            std::string_view const format) {
+        struct entry {
+            char const* key = nullptr;
+            std::shared_ptr<runtime_format const> compiled;
+        };
+        thread_local auto cache = std::array<entry, cache_size>{};
+        auto const address = reinterpret_cast<std::uintptr_t>(format.data());
+        auto& e = cache[(address >> 3) % cache_size];
+        if (e.key != format.data() || e.compiled->source != format)
+            e = {format.data(), std::make_shared<runtime_format const>(format)};
+        return e.compiled;
+    }
+
+private:
+    static constexpr std::size_t cache_size = 64;
+
+    std::string source;
+    std::string transformed;
+    std::vector<detail::native::segment> plan;
+    detail::status st = detail::status::correct;
+    std::size_t offset = 0;
+};
+
+} // namespace printx
+} // namespace rostd
+
+#endif // ROSTD_PRINTX_RUNTIME_HPP
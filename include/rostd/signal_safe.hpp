@@ -0,0 +1,110 @@
+// Copyright 2021-2024 Roku, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// clang-format off
+
+#ifndef ROSTD_SIGNAL_SAFE_HPP
+#define ROSTD_SIGNAL_SAFE_HPP
+
+#include <rostd/printx/engine.hpp>
+#include <cerrno>
+#include <cstddef>
+#include <unistd.h>
+
+namespace rostd {
+
+/**
+ * The `signal_safe` namespace provides printx formatting that may be used
+ * where only async-signal-safe functions are allowed, such as in a crash
+ * handler. Formatting is done by the native printx engine: nothing here calls
+ * a `printf`-family function, allocates, or takes a lock, and output to a file
+ * descriptor is made with `write` alone.
+ *
+ * The floating-point conversions are excluded, and formats that use them do
+ * not compile: exact conversion of a `long double` needs several kilobytes of
+ * stack, which is more than a signal stack can be assumed to have.
+ */
+namespace signal_safe {
+
+inline constexpr unsigned conversions = printx::native_conversions
+        & ~printx::detail::float_conversions;
+
+namespace detail {
+
+// Buffers output on the stack and writes it to a file descriptor.
+class fd_sink {
+public:
+    explicit fd_sink(int const fd) noexcept : fd{fd} {}
+
+    void write(char const* p, std::size_t n) noexcept {
+        if (n > sizeof buffer - used) {
+            flush();
+            if (n >= sizeof buffer) {
+                write_all(p, n);
+                return;
+            }
+        }
+        for (auto const end = p + n; p != end; buffer[used++] = *p++) {}
+    }
+
+    // Returns false if any write failed.
+    bool flush() noexcept {
+        write_all(buffer, used);
+        used = 0;
+        return !failed;
+    }
+
+private:
+    void write_all(char const* p, std::size_t n) noexcept {
+        while (n != 0 && !failed) {
+            auto const written = ::write(fd, p, n);
+            if (written <= 0) { // retrying a write of nothing would spin
+                failed = written == 0 || errno != EINTR;
+                continue;
+            }
+            p += written;
+            n -= static_cast<std::size_t>(written);
+        }
+    }
+
+    int fd;
+    bool failed = false;
+    std::size_t used = 0;
+    char buffer[256];
+};
+
+} // namespace detail
+
+// As `rostd::snprintf`, but async-signal-safe.
+template <printx::literal Fmt, typename... Args>
+int snprintf(char* s, std::size_t n, Args const&... args) noexcept {
+    auto sink = printx::buffer_sink{s, n};
+    return printx::format_to<Fmt, conversions>(sink, args...);
+}
+
+// As `dprintf`, but async-signal-safe. Returns -1 if writing failed, and
+// otherwise leaves `errno` unchanged.
+template <printx::literal Fmt, typename... Args>
+int dprintf(int fd, Args const&... args) noexcept {
+    auto const saved = errno;
+    auto sink = detail::fd_sink{fd};
+    auto const count = printx::format_to<Fmt, conversions>(sink, args...);
+    if (!sink.flush()) return -1;
+    errno = saved;
+    return count;
+}
+
+} // namespace signal_safe
+} // namespace rostd
+
+#endif // ROSTD_SIGNAL_SAFE_HPP
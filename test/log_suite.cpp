@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/log.hpp>
+#include <rostd/printx/net.hpp>
+#include <arpa/inet.h>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <unistd.h>
+
+namespace log_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+
+consteval bool fmteq(std::string_view x, std::string_view y) {
+    return x == y;
+}
+
+static_assert(sizeof(rate_limiter<10>) == 64);
+static_assert(alignof(rate_limiter<10>) == 64);
+
+static_assert(fmteq(detail::suppressed_fmt<"disk full\n">().data,
+        "suppressed %? messages like \"disk full\"\n"));
+static_assert(fmteq(detail::suppressed_fmt<"at %d%%">().data,
+        "suppressed %? messages like \"at %%d%%%%\"\n"));
+
+static_assert(fmteq(detail::json_fmt<"request done user=%? latency_ms=%.1f\n",
+        std::string, double>.data,
+        "{\"msg\":\"request done\",\"user\":\"%1${json}?\",\"latency_ms\":%2${json}.1f}\n"));
+static_assert(fmteq(detail::json_fmt<"%c v=%? c=%c ok=%? w=%[ ]?", char, double, char,
+        bool, float[2]>.data, "{\"msg\":\"%1${json}c\",\"v\":%2${json}?,"
+        "\"c\":\"%3${json}c\",\"ok\":%4$s,\"w\":[%5${json}[,]?]}\n"));
+static_assert(fmteq(detail::json_fmt<"\"%s\" failed: %?%% id=%x cpus=%[ ]?",
+        char const*, int, unsigned, std::vector<int>>.data,
+        "{\"msg\":\"\\\"%1${json}s\\\" failed: %2$?%%\",\"id\":\"%3$x\","
+        "\"cpus\":[%4$[,]?]}\n"));
+static_assert(fmteq(detail::json_fmt<"n=%-*d", int, long>.data,
+        "{\"n\":%2$-*1$d}\n"));
+static_assert(fmteq(detail::json_fmt<"at %05d n=%05d f=%#.0f w=%[ ]+03d x=%#x",
+        int, int, double, std::vector<int>, unsigned>.data,
+        "{\"msg\":\"at %1$05d\",\"n\":%2$5d,\"f\":%3${json}.0f,"
+        "\"w\":[%4$[,]3d],\"x\":\"%5$#x\"}\n"));
+
+constexpr auto here = [] { return std::source_location::current(); };
+static_assert(fmteq(detail::log_prefix<log_level::warning, here>.data,
+        "%? [log_suite.cpp:" + detail::decimal(here().line()) + "] WARNING "));
+
+} // namespace compile_time_unit_tests
+} // anonymous namespace
+} // namespace log_suite
+
+int main() {
+    using namespace std::chrono_literals;
+    using namespace std::string_view_literals;
+
+    { // A burst of `PerSecond` is admitted, then everything is suppressed.
+        static constinit rostd::printx::rate_limiter<1000> limiter;
+        auto suppressed = std::uint64_t{};
+        auto admitted = 0;
+        while (limiter.try_acquire(suppressed)) {
+            assert(suppressed == 0);
+            ++admitted;
+        }
+        assert(admitted >= 1000);
+        for (int i = 0; i < 99; ++i) limiter.try_acquire(suppressed);
+
+        // Once tokens have been replenished, the count of dropped events is
+        // reported exactly once.
+        std::this_thread::sleep_for(5ms);
+        assert(limiter.try_acquire(suppressed));
+        assert(suppressed >= 100);
+        std::this_thread::sleep_for(5ms);
+        assert(limiter.try_acquire(suppressed));
+        assert(suppressed == 0);
+    }
+
+    { // JSON objects, from the same formats as text.
+        auto const file = std::tmpfile();
+        auto const saved = dup(STDERR_FILENO);
+        std::fflush(stderr);
+        dup2(fileno(file), STDERR_FILENO);
+        auto const n = rostd::log_json<"%2$? done user=%1$? ms=%3$?\n">(
+                std::string{"a\"b"}, "task", 12);
+        std::fflush(stderr);
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+        char text[128] = {};
+        std::rewind(file);
+        std::fread(text, 1, sizeof text, file);
+        assert(text == std::string_view{
+                "{\"msg\":\"task done\",\"user\":\"a\\\"b\",\"ms\":12}\n"});
+        assert(n == 42);
+        std::fclose(file);
+    }
+
+    { // Values that are not JSON as printf prints them.
+        auto const file = std::tmpfile();
+        auto const saved = dup(STDERR_FILENO);
+        std::fflush(stderr);
+        dup2(fileno(file), STDERR_FILENO);
+        double const w[] = {0.5, -std::numeric_limits<double>::infinity()};
+        rostd::log_json<"v=%? c=%? ok=%? w=%[ ]?\n">(std::nan(""), '"', true, w);
+        std::fflush(stderr);
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+        char text[128] = {};
+        std::rewind(file);
+        std::fread(text, 1, sizeof text, file);
+        assert(text == std::string_view{
+                "{\"v\":null,\"c\":\"\\\"\",\"ok\":true,\"w\":[0.5,null]}\n"});
+        std::fclose(file);
+    }
+
+    { // Text that traits<> render is a JSON string.
+        auto const file = std::tmpfile();
+        auto const saved = dup(STDERR_FILENO);
+        std::fflush(stderr);
+        dup2(fileno(file), STDERR_FILENO);
+        rostd::log_json<"peer=%? n=%?\n">(in_addr{htonl(0xc0000201)}, 3);
+        std::fflush(stderr);
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+        char text[128] = {};
+        std::rewind(file);
+        std::fread(text, 1, sizeof text, file);
+        assert(text == std::string_view{"{\"peer\":\"192.0.2.1\",\"n\":3}\n"});
+        std::fclose(file);
+    }
+
+    { // Timestamps are formatted in full only when the second changes.
+        using namespace std::chrono;
+        using rostd::printx::detail::cached_time;
+        auto const t = sys_days{2024y / 2 / 29} + 23h + 59min + 59s;
+        auto const text = cached_time(t + 5ms);
+        assert(text == "2024-02-29T23:59:59.005Z"sv);
+        assert(cached_time(t + 999ms) == text);
+        assert(text == "2024-02-29T23:59:59.999Z"sv);
+        assert(cached_time(t + 1000ms) == "2024-03-01T00:00:00.000Z"sv);
+        assert(cached_time(sys_time<nanoseconds>{t + 12ns})
+                == "2024-02-29T23:59:59.000000012Z"sv);
+        assert(cached_time(t) == "2024-02-29T23:59:59Z"sv);
+        char line[64];
+        rostd::snprintf<"%? %?">(line, sizeof line,
+                rostd::printx::timestamp<milliseconds>{}, "up");
+        assert(std::string_view{line}.size() == 27);
+    }
+
+    { // Log lines carry a prefix composed into the format.
+        auto const file = std::tmpfile();
+        auto const saved = dup(STDERR_FILENO);
+        std::fflush(stderr);
+        dup2(fileno(file), STDERR_FILENO);
+        auto const line = __LINE__ + 1;
+        auto const n = ROSTD_LOG(error, "%2$s %1$d%%\n", 42, "disk at");
+        rostd::printx::log_threshold = rostd::printx::log_level::info;
+        auto const skipped = ROSTD_LOG(debug, "verbose\n");
+        rostd::printx::log_threshold = rostd::printx::log_level::debug;
+        std::fflush(stderr);
+        dup2(saved, STDERR_FILENO);
+        close(saved);
+        char text[128] = {};
+        std::rewind(file);
+        std::fread(text, 1, sizeof text, file);
+        char expected[64];
+        rostd::snprintf<" [log_suite.cpp:%d] ERROR disk at 42%%\n">(
+                expected, sizeof expected, line);
+        // After a timestamp like 2024-02-29T23:59:59.000005Z.
+        assert(std::string_view{text}.substr(27) == expected);
+        assert(n == static_cast<int>(std::string_view{text}.size()));
+        assert(skipped == 0);
+        std::fclose(file);
+    }
+
+    { // Each call site gets its own limiter, even with the same format.
+        auto written = 0;
+        for (int i = 0; i < 10; ++i) {
+            written += rostd::log_ratelimited<"%s %?\n", 2>("storm", i) > 0;
+            written += rostd::log_ratelimited<"%s %?\n", 2>("storm", 1L * i) > 0;
+        }
+        assert(written == 4);
+        auto const again = [] {
+            return rostd::log_ratelimited<"%s %?\n", 2>("storm", 'x') > 0;
+        };
+        assert(again() && again() && !again());
+    }
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/binary.hpp>
+#include <rostd/printx/net.hpp>
+#include <climits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Span { std::string_view name; long first, last; };
+
+namespace rostd::printx::detail {
+template <> struct traits<Span> {
+    static constexpr auto fmt = "%? [%?, %?)";
+    static constexpr auto fwd_args(Span const& s) {
+        return std::tie(s.name, s.first, s.last);
+    }
+};
+} // namespace rostd::printx::detail
+
+namespace printx_binary_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx::detail::binary;
+
+static_assert(zigzag(0) == 0);
+static_assert(zigzag(-1) == 1);
+static_assert(zigzag(1) == 2);
+static_assert(zigzag(-2) == 3);
+static_assert(zigzag(INT64_MIN) == UINT64_MAX);
+static_assert(unzigzag(zigzag(INT64_MIN)) == INT64_MIN);
+static_assert(unzigzag(zigzag(INT64_MAX)) == INT64_MAX);
+static_assert(unzigzag(zigzag(-123456789)) == -123456789);
+
+} // namespace compile_time_unit_tests
+
+struct stream {
+    std::vector<std::byte> bytes;
+    std::vector<std::size_t> sizes; // of each record
+    void operator()(std::span<std::byte const> record) {
+        bytes.insert(bytes.end(), record.begin(), record.end());
+        sizes.push_back(record.size());
+    }
+};
+
+} // anonymous namespace
+} // namespace printx_binary_suite
+
+int main() {
+    using namespace std::literals;
+    using namespace rostd::printx;
+    using printx_binary_suite::stream;
+
+    { // Varints round trip at their boundaries.
+        auto bytes = std::vector<std::byte>{};
+        auto e = binary_encoder{bytes};
+        for (auto const v : {0ull, 127ull, 128ull, 16383ull, 16384ull, ~0ull})
+            e.varint(v);
+        assert(bytes.size() == 1 + 1 + 2 + 2 + 3 + 10);
+        auto d = binary_decoder{bytes};
+        for (auto const v : {0ull, 127ull, 128ull, 16383ull, 16384ull, ~0ull})
+            assert(d.varint() == v);
+        assert(d.at_end() && !d.failed());
+        assert(d.varint() == 0 && d.failed());
+    }
+
+    auto out = stream{};
+    auto writer = binary_writer{std::ref(out)};
+    writer.write_at<"%? items, %? left\n">(1'000'000'000, 3, -2LL);
+    writer.write_at<"%? items, %? left\n">(1'000'000'250, 4, -1LL);
+    writer.write_at<"%s=%?\n">(1'000'000'100, "name"s, 2.5);
+    writer.write_at<"[%-6?] %p %?\n">(1'000'000'200, "pad"sv, nullptr, 'x');
+
+    // The first record defines its format (9 bytes); after that, small
+    // values take one byte each.
+    assert(out.sizes[0] == 5 + 9 + 1 + 5 + 1 + 1);
+    assert(out.sizes[1] == 1 + 2 + 1 + 1);
+    assert(out.sizes[2] == 9 + 1 + 2 + 5 + 8); // the delta is -150
+
+    auto reader = binary_reader{out.bytes};
+    auto entry = binary_entry{};
+    assert(reader.next(entry));
+    assert(entry.timestamp == 1'000'000'000);
+    assert(entry.text == "3 items, -2 left\n");
+    assert(std::string_view{entry.format->format} == "%? items, %? left\n");
+    assert(reader.next(entry));
+    assert(entry.timestamp == 1'000'000'250);
+    assert(entry.text == "4 items, -1 left\n");
+    assert(reader.next(entry));
+    assert(entry.timestamp == 1'000'000'100);
+    assert(entry.text == "name=2.5\n");
+    assert(reader.next(entry));
+    assert(entry.text == "[pad   ] (nil) x\n");
+    assert(!reader.next(entry));
+    assert(reader.error == nullptr);
+
+    { // Members of a type with a sub-format are encoded by their codecs.
+        auto spans = stream{};
+        auto w = binary_writer{std::ref(spans)};
+        w.write_at<"span %?\n">(7, Span{"rows"sv, -5, 300});
+        auto r = binary_reader{spans.bytes};
+        assert(r.next(entry));
+        assert(entry.text == "span rows [-5, 300)\n");
+        assert(!r.next(entry) && !r.error);
+    }
+
+    { // Rendered text is encoded as a string.
+        auto rendered = stream{};
+        auto w = binary_writer{std::ref(rendered)};
+        auto const mac = mac_address{{0xde, 0xad, 0xbe, 0xef, 0x00, 0x01}};
+        w.write_at<"%? via %?\n">(1, in_addr{htonl(0x0a0000ff)}, mac);
+        char buf[64];
+        for (auto i = 0u; i < detail::render_slots; ++i) // reuses every slot
+            rostd::snprintf<"%? %?">(buf, sizeof buf, in_addr{}, mac_address{});
+        auto r = binary_reader{rendered.bytes};
+        assert(r.next(entry));
+        assert(entry.text == "10.0.0.255 via de:ad:be:ef:00:01\n");
+        assert(!r.next(entry) && !r.error);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    { // 128-bit integers are encoded as their digits.
+        auto digits = stream{};
+        auto w = binary_writer{std::ref(digits)};
+        auto const big = detail::uint128{1} << 100;
+        w.write_at<"%? %? %?\n">(1, big, -static_cast<detail::int128>(big), hex(big));
+        auto r = binary_reader{digits.bytes};
+        assert(r.next(entry));
+        assert(entry.text == "1267650600228229401496703205376 "
+                "-1267650600228229401496703205376 10000000000000000000000000\n");
+        assert(!r.next(entry) && !r.error);
+    }
+#endif
+
+    { // Repeated strings are interned per stream.
+        auto plain = stream{};
+        auto interned = stream{};
+        auto w1 = binary_writer{std::ref(plain)};
+        auto w2 = binary_writer{std::ref(interned), true};
+        char const* hosts[] = {"alpha.example.com", "beta.example.com"};
+        for (int i = 0; i < 10; ++i) {
+            w1.write_at<"connect %? %?\n">(i, hosts[i % 2], std::string{hosts[i % 2]});
+            w2.write_at<"connect %? %?\n">(i, hosts[i % 2], std::string{hosts[i % 2]});
+        }
+        assert(interned.bytes.size() * 4 < plain.bytes.size());
+        auto r = binary_reader{interned.bytes};
+        for (int i = 0; i < 10; ++i) {
+            assert(r.next(entry));
+            assert(entry.text == "connect "s + hosts[i % 2] + " " + hosts[i % 2] + "\n");
+        }
+        assert(!r.next(entry) && !r.error);
+    }
+
+    { // A moved writer carries on with the same stream.
+        auto moved = stream{};
+        auto w = std::optional<binary_writer<std::reference_wrapper<stream>>>{};
+        {
+            auto first = binary_writer{std::ref(moved), true};
+            first.write_at<"host %?\n">(1, "alpha");
+            w.emplace(std::move(first));
+        }
+        w->write_at<"host %?\n">(2, "alpha");
+        w->write_at<"host %?\n">(3, "beta");
+        assert(moved.sizes.size() == 3 && moved.sizes[1] > 0);
+        auto r = binary_reader{moved.bytes};
+        for (auto const host : {"alpha", "alpha", "beta"}) {
+            assert(r.next(entry));
+            assert(entry.text == "host "s + host + "\n");
+        }
+        assert(!r.next(entry) && !r.error);
+    }
+
+    { // Truncated and foreign streams are reported.
+        out.bytes.pop_back();
+        auto r = binary_reader{out.bytes};
+        while (r.next(entry)) {}
+        assert(r.error);
+        auto junk = std::vector<std::byte>(16);
+        assert(binary_reader{junk}.error);
+    }
+}
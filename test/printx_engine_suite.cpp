@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+// Built with ROSTD_PRINTX_FREESTANDING: printx must not provide the wrappers
+// of the C library functions, so these names are still free.
+#include <rostd/printx/engine.hpp>
+namespace rostd {
+[[maybe_unused]] inline int printf, fprintf, snprintf, sprintf;
+} // namespace rostd
+
+#include "test.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace printx_engine_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+
+// Formats forwarded arguments with the native engine at compile time.
+template <literal Fmt, typename... Args>
+consteval bool renders(std::string_view const expected, Args const... args) {
+    char buffer[128] = {};
+    auto sink = buffer_sink{buffer, sizeof buffer};
+    auto const n = detail::native::render<Fmt>(sink, args...);
+    return expected == buffer && n == static_cast<int>(expected.size());
+}
+
+static_assert(renders<"%d|%5s|%-4c|">("-42|  abc|x   |", -42, "abc", 'x'));
+static_assert(renders<"%f %e %g">("0.100000 1.000000e-01 0.1", 0.1, 0.1, 0.1));
+static_assert(renders<"%.20f">("0.10000000000000000555", 0.1));
+static_assert(renders<"%.0f %.0f %.0f %.1f">("0 2 2 0.1", 0.5, 1.5, 2.5, 0.05));
+static_assert(renders<"%g %g %g">("1e+06 1e-05 123457", 1e6, 1e-5, 123456.789));
+static_assert(renders<"%a %A %.1a">("0x1.8p+1 0X0.0000000000001P-1022 0x2.0p+0", 3.0,
+        std::numeric_limits<double>::denorm_min(), 1.97));
+static_assert(renders<"%La %Lg">("0x8p-3 0.1", 1.0L, 0.1L));
+static_assert(renders<"%f %E">("inf -NAN", std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::quiet_NaN()));
+
+enum class Mode { fast = 2 };
+inline constexpr char build_id[] = "abc123";
+
+static_assert(std::string_view{format_literal<"build %? (%?)", 42, build_id>().data}
+        == "build 42 (abc123)");
+static_assert(std::string_view{format_literal<"%? %.3f %#x %-4?|", Mode::fast, 3.14159,
+        255u, literal{"lit"}>().data} == "2 3.142 0xff lit |");
+static_assert(sizeof format_literal<"100%%">().data == 5);
+static_assert(std::string_view{format_literal<"%? %-8?|%3? %5?|",
+        ~rostd::printx::detail::uint128{0} / 3, rostd::printx::detail::int128{-12},
+        rostd::printx::detail::int128{-123456},
+        rostd::printx::hex(255u)>().data}
+        == "113427455640312821154458202477256070485 -12     |-123456    ff|");
+static_assert(std::string_view{format_literal<"{\"id\":\"%{json}?\",\"n\":\"%{json}-5?\"}",
+        rostd::printx::hex<'X'>(~rostd::printx::detail::uint128{0} >> 64),
+        rostd::printx::detail::int128{-12}>().data}
+        == "{\"id\":\"FFFFFFFFFFFFFFFF\",\"n\":\"-12  \"}");
+
+inline constexpr int values[] = {1, 22, -3};
+inline constexpr unsigned char bytes[] = {0x0a, 0xff};
+static_assert(renders<"%[, ]-3d|%[]02hhx|%[,]d">("1  , 22 , -3 |0aff|",
+        std::span{values}, std::span{bytes}, std::span<int const>{}));
+inline constexpr std::byte packet[] = {std::byte{0xde}, std::byte{0xad},
+        std::byte{'o'}, std::byte{'k'}, std::byte{0}, std::byte{0x7f}};
+static_assert(renders<"%4[ ]02x|%[:]02X|%1[-]d">("dead6f6b 007f|DE:AD|1-22--3",
+        std::span{packet}, std::span{packet, 2}, std::span{values}));
+static_assert(renders<"%2[ ]02hhx  |%[]c|">("dead 6f6b 007f  |..ok..|",
+        std::span{packet}, std::span{packet}));
+static_assert(renders<"{\"%{json}s\": \"%{json}.4s\"}">(
+        "{\"a\\\"b\": \"\\u0001\\\\\\t\\n\"}", "a\"b", "\x01\\\t\ntrimmed"));
+static_assert(renders<"\"%{c}s\" %{c}-6s|">("\"\\007\\033[0m\\177\\\"\" \\n    |",
+        "\a\x1b[0m\x7f\"", "\n"));
+static_assert(renders<"%{csv}s,%{csv}s,%{csv}s">("plain,\"a,b\",\"say \"\"hi\"\"\"",
+        "plain", "a,b", "say \"hi\""));
+static_assert(std::string_view{format_literal<"[%[ ]?] %[;]?",
+        std::array{1.5, 2.0}, std::array{1, 22}>().data} == "[1.5 2] 1;22");
+
+} // namespace compile_time_unit_tests
+
+std::string expected_buffer(8192, '\0'), actual_buffer(8192, '\0');
+
+// Formats with the C library and with the native engine, and checks that
+// they agree.
+template <rostd::printx::literal Fmt, typename... Args>
+bool same(Args const&... args) {
+    using namespace rostd::printx;
+    auto const n = invoke([&](auto const&... args) {
+            static constexpr auto fmt = build_fmt<Fmt, Args...>();
+            return std::snprintf(expected_buffer.data(), expected_buffer.size(),
+                    fmt.data, args...);
+        }, args...);
+    auto sink = buffer_sink{actual_buffer.data(), actual_buffer.size()};
+    auto const m = format_to<Fmt>(sink, args...);
+    if (n == m && std::strcmp(expected_buffer.data(), actual_buffer.data()) == 0)
+        return true;
+    std::fprintf(stderr, "mismatch: \"%s\" != \"%s\"\n", expected_buffer.data(),
+            actual_buffer.data());
+    return false;
+}
+
+template <typename Float>
+bool same_all_formats(int const width, int const precision, Float const v) {
+    return same<"%*.*f">(width, precision, v)
+        && same<"%-*.*e">(width, precision, v)
+        && same<"%+*.*g">(width, precision, v)
+        && same<"%#*.*g">(width, precision, v)
+        && same<"%0*.*f">(width, precision, v)
+        && same<"% *.*E">(width, precision, v)
+        && same<"%*.*G">(width, precision, v)
+        && same<"%0*.*a">(width, precision, v)
+        && same<"%#*.*A">(width, precision, v)
+        && same<"%*a|%g|%e|%f">(width, v, v, v, v);
+}
+
+} // anonymous namespace
+} // namespace printx_engine_suite
+
+int main() {
+    using printx_engine_suite::same;
+    using printx_engine_suite::same_all_formats;
+    using limits = std::numeric_limits<double>;
+
+    { // Output through a putc-style function.
+        static std::string out;
+        auto sink = rostd::printx::putc_sink{[](char c) { out += c; }};
+        assert(rostd::printx::format_to<"%? + %? = %?">(sink, 1, 2.5, 3.5) == 13);
+        assert(out == "1 + 2.5 = 3.5");
+    }
+
+    double const specials[] = {
+        0.0, -0.0, 0.5, 1.5, 2.5, 0.125, 0.375, 1e-300, 1e300, 123456789.0,
+        9.5, 99.5, 999.999, 0.0009999, 9.9999e-5, 1e15, 1e16, 1e17, 1e21,
+        limits::min(), limits::max(), limits::denorm_min(), limits::epsilon(),
+        limits::infinity(), -limits::infinity(), limits::quiet_NaN(),
+        -limits::quiet_NaN(), 0x1.fffffffffffffp0, 0x1.0000000000001p0,
+    };
+    for (auto const v : specials) {
+        for (auto const precision : {-1, 0, 1, 2, 3, 5, 6, 13, 17, 30}) {
+            for (auto const width : {0, 8, 40})
+                assert(same_all_formats(width, precision, v));
+        }
+    }
+
+    auto random = std::mt19937_64{20240229};
+    for (int i = 0; i < 3000; ++i) {
+        auto const bits = random();
+        auto const width = static_cast<int>(random() % 30);
+        auto const precision = static_cast<int>(random() % 40) - 2;
+        assert(same_all_formats(width, precision, std::bit_cast<double>(bits)));
+        auto const f = std::bit_cast<float>(static_cast<std::uint32_t>(bits));
+        assert(same_all_formats(width, precision, f));
+        // Values near small powers of ten exercise rounding and notation.
+        auto const near = std::ldexp(static_cast<double>(bits >> 11), -53)
+                * std::pow(10.0, static_cast<int>(random() % 40) - 20);
+        assert(same_all_formats(width, precision, near));
+    }
+
+    for (int i = 0; i < 50; ++i) {
+        auto const x = std::ldexp(static_cast<long double>(random()),
+                static_cast<int>(random() % 32000) - 16000 - 64);
+        auto const precision = static_cast<int>(random() % 30) - 2;
+        assert(same_all_formats(0, precision, x));
+        assert(same_all_formats(0, precision, -x));
+    }
+    assert(same_all_formats(0, -1, std::numeric_limits<long double>::max()));
+    assert(same_all_formats(0, 70, std::numeric_limits<long double>::denorm_min()));
+
+    return 0;
+}
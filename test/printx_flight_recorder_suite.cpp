@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/flight_recorder.hpp>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <sys/wait.h>
+
+int main() {
+    using namespace std::literals;
+    using rostd::printx::flight_recorder;
+
+    char path[] = "/tmp/printx_flight_recorder_XXXXXX";
+    auto const fd = ::mkstemp(path);
+    assert(fd >= 0);
+    ::close(fd);
+
+    { // Records written by a process that crashes can be recovered.
+        auto const child = ::fork();
+        assert(child >= 0);
+        if (child == 0) {
+            auto recorder = flight_recorder{path, {2, 8, 128}};
+            if (!recorder) std::_Exit(1);
+            for (int i = 0; i < 20; ++i)
+                recorder.record<"main %? of %?">(i, "twenty"s);
+            std::thread{[&] {
+                recorder.record<"worker says %?">("goodbye");
+            }}.join();
+            recorder.record<"%?">(std::string(200, 'x')); // too big for a slot
+            std::abort();
+        }
+        auto status = 0;
+        ::waitpid(child, &status, 0);
+        assert(WIFSIGNALED(status));
+
+        auto const records = flight_recorder::recover(path);
+        // The main thread's lane keeps its last 8 records; the worker has its
+        // own lane.
+        assert(records.size() == 9);
+        auto main_thread = records.back().thread;
+        auto worker = 0u;
+        auto main_records = std::vector<std::string>{};
+        for (auto const& r : records) {
+            if (r.thread == main_thread) main_records.push_back(r.text);
+            else worker = r.thread, assert(r.text == "worker says goodbye");
+        }
+        assert(worker != 0 && worker != main_thread);
+        assert(main_records.size() == 8);
+        assert(main_records.front() == "main 13 of twenty");
+        assert(main_records[6] == "main 19 of twenty");
+        assert(main_records.back() == "%? <arguments truncated>");
+
+        auto const last = flight_recorder::recover(path, 2);
+        assert(last.size() == 3);
+        assert(last.back().text == "%? <arguments truncated>");
+    }
+
+    { // Records of formats that are not in the catalog keep their id.
+        {
+            auto recorder = flight_recorder{path, {1, 2, 64}};
+            assert(recorder);
+            recorder.record<"soon unknown %?">(1);
+        }
+        auto const f = std::fopen(path, "r+");
+        auto const id = std::uint64_t{0xfedcba9876543210};
+        std::fseek(f, 64 + 64 + 8, SEEK_SET); // header, head, slot sequence
+        std::fwrite(&id, sizeof id, 1, f);
+        std::fclose(f);
+        auto const records = flight_recorder::recover(path);
+        assert(records.size() == 1);
+        assert(records[0].text == "<unknown format fedcba9876543210>");
+    }
+
+    { // Anything else is not recovered.
+        assert(flight_recorder::recover("/nonexistent/flight").empty());
+        auto const f = std::fopen(path, "w");
+        std::fputs("not a flight recorder", f);
+        std::fclose(f);
+        assert(flight_recorder::recover(path).empty());
+    }
+
+    ::unlink(path);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx.hpp>
+#include <string_view>
+
+#if !defined(ROSTD_PRINTX_INSTRUMENT)
+    #error "this suite must be built with ROSTD_PRINTX_INSTRUMENT"
+#endif
+
+namespace printx_instrument_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+using instrument::call_site;
+
+static_assert(call_site::lower_bound(0) == 0);
+static_assert(call_site::lower_bound(7) == 7);
+static_assert(call_site::lower_bound(8) == 8);
+static_assert(call_site::lower_bound(9) == 10);
+static_assert(call_site::lower_bound(12) == 16);
+static_assert(call_site::lower_bound(call_site::buckets - 1) == 7ull << 37);
+
+static_assert(format_id<"%?", int>() == format_id<"%?", int const&>());
+static_assert(format_id<"%?", int>() != format_id<"%?", long>());
+static_assert(format_id<"%?", int>() != format_id<"%d", int>());
+static_assert(format_id<"a", int>() != format_id<"", int>());
+
+} // namespace compile_time_unit_tests
+} // anonymous namespace
+} // namespace printx_instrument_suite
+
+int main() {
+    using rostd::printx::instrument::call_site;
+    char buf[64] = {};
+
+    for (int i = 0; i < 10; ++i) rostd::snprintf<"%?-%?">(buf, sizeof buf, i, 'x');
+    rostd::sprintf<"%s">(buf, "hello");
+
+    auto const* tens = static_cast<call_site const*>(nullptr);
+    auto const* hello = static_cast<call_site const*>(nullptr);
+    for (auto s = rostd::printx::instrument::first(); s; s = s->next()) {
+        if (std::string_view{s->format} == "%?-%?") tens = s;
+        if (std::string_view{s->format} == "%s") hello = s;
+    }
+    assert(tens && hello);
+    assert(std::string_view{tens->transformed} == "%d-%c");
+    assert((tens->id == rostd::printx::format_id<"%?-%?", int, char>()));
+    assert(tens->calls() == 10);
+    assert(tens->bytes() == 10 * 3);
+    assert(hello->calls() == 1);
+    assert(hello->bytes() == 5);
+
+    auto histogram_total = std::uint64_t{};
+    for (std::size_t i = 0; i < call_site::buckets; ++i)
+        histogram_total += tens->count(i);
+    assert(histogram_total == 10);
+    assert(tens->quantile(0.5) <= tens->quantile(0.99));
+
+    rostd::printx::instrument::dump(stdout);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/localized.hpp>
+#include <string>
+#include <string_view>
+
+namespace printx_localized_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx::detail;
+
+static_assert(in_order<"%? files in %?", 2>());
+static_assert(in_order<"%1$? fichiers dans %2$?", 2>());
+static_assert(!in_order<"%2$? : %1$? fichiers", 2>());
+
+} // namespace compile_time_unit_tests
+
+// Same argument order in every locale: one call, with a table of formats.
+using files_in = rostd::printx::localized<
+        "%? files in %?",
+        "%1$? fichiers dans %2$?",
+        "%?|%-6?|">;
+
+// Reordered in one locale: a table of calls.
+using greeting = rostd::printx::localized<
+        "Hello %?, you have %? messages",
+        "%2$? Nachrichten für %1$?">;
+
+} // anonymous namespace
+} // namespace printx_localized_suite
+
+int main() {
+    using namespace std::literals;
+    using namespace printx_localized_suite;
+    using rostd::printx::set_locale;
+    char buf[64];
+
+    static_assert(files_in::locales == 3);
+    set_locale(0);
+    assert(files_in::snprintf(buf, sizeof buf, 12, "/tmp"sv) == 16);
+    assert(buf == "12 files in /tmp"sv);
+    assert(greeting::sprintf(buf, "Ann"s, 3) == 30);
+    assert(buf == "Hello Ann, you have 3 messages"sv);
+
+    set_locale(1);
+    files_in::snprintf(buf, sizeof buf, 12, "/tmp"sv);
+    assert(buf == "12 fichiers dans /tmp"sv);
+    greeting::sprintf(buf, "Ann"s, 3);
+    assert(buf == "3 Nachrichten für Ann"sv);
+
+    set_locale(2); // missing from `greeting`: its first format is used
+    files_in::snprintf(buf, sizeof buf, 12, "/tmp"sv);
+    assert(buf == "12|/tmp  |"sv);
+    greeting::sprintf(buf, "Ann"s, 3);
+    assert(buf == "Hello Ann, you have 3 messages"sv);
+
+    set_locale(0);
+    return 0;
+}
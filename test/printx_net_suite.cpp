@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/net.hpp>
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace printx_net_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+
+consteval bool rendered_as(std::string_view text, auto const& value) {
+    char out[64] = {};
+    auto const end = detail::traits<std::remove_cvref_t<decltype(value)>>::render(out, value);
+    return std::string_view{out, end} == text;
+}
+
+static_assert(detail::concepts::renders<in6_addr>);
+static_assert(detail::concepts::renders<sockaddr_storage>);
+static_assert(rendered_as("00:1a:2b:3c:4d:5e", mac_address{{0, 0x1a, 0x2b, 0x3c, 0x4d, 0x5e}}));
+static_assert(rendered_as("123e4567-e89b-12d3-a456-426614174000", uuid{{0x12, 0x3e,
+        0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3, 0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00}}));
+
+consteval bool ipv6_as(std::string_view text, std::array<std::uint8_t, 16> bytes) {
+    char out[48] = {};
+    return std::string_view{out, detail::net::put_ipv6(out, bytes.data())} == text;
+}
+
+static_assert(ipv6_as("::", {}));
+static_assert(ipv6_as("::1", {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+static_assert(ipv6_as("2001:db8::1", {0x20, 1, 0xd, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+static_assert(ipv6_as("2001:db8:0:1:1:1:1:1", // a single zero group stays
+        {0x20, 1, 0xd, 0xb8, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1}));
+static_assert(ipv6_as("2001:0:0:1::1", // the longest run
+        {0x20, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1}));
+static_assert(ipv6_as("2001:db8::1:0:0:1", // the first of equal runs
+        {0x20, 1, 0xd, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1}));
+static_assert(ipv6_as("fe80::", {0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}));
+static_assert(ipv6_as("::ffff:192.0.2.1",
+        {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 192, 0, 2, 1}));
+
+} // namespace compile_time_unit_tests
+} // anonymous namespace
+} // namespace printx_net_suite
+
+int main() {
+    using namespace std::literals;
+    using rostd::printx::mac_address;
+    using rostd::printx::uuid;
+    char buf[160];
+
+    { // Addresses print as inet_ntop would, in any call.
+        auto v4 = in_addr{};
+        auto v6 = in6_addr{};
+        inet_pton(AF_INET, "10.0.255.7", &v4);
+        inet_pton(AF_INET6, "2001:db8:0:0:8:800:200c:417a", &v6);
+        rostd::snprintf<"%? -> %-20?|">(buf, sizeof buf, v4, v6);
+        assert(buf == "10.0.255.7 -> 2001:db8::8:800:200c:417a|"sv);
+        auto sink = rostd::printx::buffer_sink{buf, sizeof buf};
+        rostd::printx::format_to<"%? -> %.9?|">(sink, v4, v6); // native
+        assert(buf == "10.0.255.7 -> 2001:db8:|"sv);
+        rostd::snprintf<"\"%{json}?\" %{c}-12?|%{csv}.4?">(buf, sizeof buf, v4, v4, v6);
+        assert(buf == "\"10.0.255.7\" 10.0.255.7  |2001"sv);
+
+        // Random addresses, with runs of zero groups.
+        std::srand(7);
+        for (int i = 0; i < 10000; ++i) {
+            for (auto& byte : v6.s6_addr)
+                byte = std::rand() % 4 ? 0 : static_cast<std::uint8_t>(std::rand());
+            if (!std::memcmp(v6.s6_addr, "\0\0\0\0\0\0\0\0\0\0\0\0", 12)) continue;
+            char expected[INET6_ADDRSTRLEN];
+            inet_ntop(AF_INET6, &v6, expected, sizeof expected);
+            rostd::snprintf<"%?">(buf, sizeof buf, v6);
+            assert(buf == std::string_view{expected});
+        }
+    }
+
+    { // Socket addresses, with their ports.
+        auto storage = sockaddr_storage{};
+        auto& v4 = reinterpret_cast<sockaddr_in&>(storage);
+        v4.sin_family = AF_INET;
+        v4.sin_port = htons(8080);
+        inet_pton(AF_INET, "192.0.2.33", &v4.sin_addr);
+        rostd::snprintf<"peer %?">(buf, sizeof buf, storage);
+        assert(buf == "peer 192.0.2.33:8080"sv);
+
+        storage = {};
+        auto& v6 = reinterpret_cast<sockaddr_in6&>(storage);
+        v6.sin6_family = AF_INET6;
+        v6.sin6_port = htons(22);
+        v6.sin6_scope_id = 3;
+        inet_pton(AF_INET6, "fe80::1", &v6.sin6_addr);
+        rostd::snprintf<"peer %? %?">(buf, sizeof buf, storage, v6);
+        assert(buf == "peer [fe80::1%3]:22 [fe80::1%3]:22"sv);
+
+        storage.ss_family = AF_UNIX;
+        auto sink = rostd::printx::buffer_sink{buf, sizeof buf};
+        rostd::printx::format_to<"peer %?">(sink, storage);
+        assert(buf == "peer (family "s + std::to_string(AF_UNIX) + ")");
+    }
+
+    { // Identifiers, in hex.
+        auto const id = uuid{{0xf8, 0x1d, 0x4f, 0xae, 0x7d, 0xec, 0x11, 0xd0,
+                0xa7, 0x65, 0x00, 0xa0, 0xc9, 0x1e, 0x6b, 0xf6}};
+        auto const mac = mac_address{{0xde, 0xad, 0xbe, 0xef, 0x00, 0x01}};
+        rostd::snprintf<"%? on %?">(buf, sizeof buf, id, mac);
+        assert(buf == "f81d4fae-7dec-11d0-a765-00a0c91e6bf6 on de:ad:be:ef:00:01"sv);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/packed.hpp>
+#include <rostd/printx/net.hpp>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class Color : unsigned char { red = 1, green = 2 };
+struct Label { std::string text; Color color; };
+
+namespace rostd::printx::detail {
+template <> struct traits<Label> {
+    static constexpr auto fmt = "%s (%?)";
+    static constexpr auto fwd_args(Label const& l) { return std::tie(l.text, l.color); }
+};
+} // namespace rostd::printx::detail
+
+namespace printx_packed_suite {
+namespace { // anonymous
+
+using namespace rostd::printx;
+
+// Packs `args`, destroys them, then formats the pack as `Fmt`.
+template <literal Fmt, char_ptr Policy = char_ptr::copy, typename... Args>
+std::string roundtrip(std::vector<std::byte>& storage, Args const&... args) {
+    using pack = basic_packed_args<Policy, Args...>;
+    storage.resize(pack::size(args...));
+    assert(pack::pack(storage, args...) == storage.size());
+    auto const copy = storage; // trivially copyable: bytes are all there is
+    std::fill(storage.begin(), storage.end(), std::byte{0xcc});
+    char buf[256] = {};
+    pack::apply(copy.data(), [&](auto const&... args) {
+        static constexpr auto fmt = build_fmt<Fmt, Args...>();
+        return std::snprintf(buf, sizeof buf, fmt.data, args...);
+    });
+    return buf;
+}
+
+} // anonymous namespace
+} // namespace printx_packed_suite
+
+int main() {
+    using namespace std::literals;
+    using namespace rostd::printx;
+    using printx_packed_suite::roundtrip;
+    auto storage = std::vector<std::byte>{};
+
+    assert(roundtrip<"none">(storage) == "none");
+    assert(storage.empty());
+
+    assert((roundtrip<"%? %? %? %?">(storage, 42, -7LL, 2.5, 'c')
+            == "42 -7 2.5 c"));
+    assert(storage.size() == sizeof(int) + sizeof(long long) + sizeof(double)
+                             + sizeof(char));
+
+    assert((roundtrip<"%?|%?">(storage, Color::green, true) == "2|1"));
+
+    { // Strings are copied inline, whatever their source.
+        auto str = "a std::string"s;
+        auto view = std::string_view{"view of a longer string", 7};
+        auto chars = std::vector<char>{'v', 'e', 'c'};
+        char array[] = "array";
+        char const* ptr = "pointer";
+        char const* null = nullptr;
+        assert((roundtrip<"%?/%?/%?/%?/%?/%?">(storage, str, view, chars,
+                array, ptr, null) == "a std::string/view of/vec/array/pointer/(null)"));
+        assert(storage.size() == 6 * sizeof(std::uint32_t)
+                + str.size() + 1 + view.size() + chars.size()
+                + sizeof array + std::strlen(ptr) + 1);
+    }
+
+    { // Members of a type with a sub-format are captured by their codecs.
+        assert((roundtrip<"<%?>">(storage, Label{"a std::string label", Color::red})
+                == "<a std::string label (1)>"));
+        assert(storage.size() == sizeof(std::uint32_t) + 20 + sizeof(Color));
+    }
+
+    { // Width and precision still apply to captured string views.
+        assert((roundtrip<"[%*?]">(storage, 8, "abc"sv) == "[     abc]"));
+    }
+
+    { // Rendered text is captured, not the slot it was rendered into.
+        auto const addr = in_addr{htonl(0xc0000201)};
+        auto const id = uuid{{0xf8, 0x1d, 0x4f, 0xae, 0x7d, 0xec, 0x11, 0xd0,
+                0xa7, 0x65, 0x00, 0xa0, 0xc9, 0x1e, 0x6b, 0xf6}};
+        using pack = packed_args<in_addr, uuid>;
+        storage.resize(pack::size(addr, id));
+        assert(pack::pack(storage, addr, id) == storage.size());
+        assert(storage.size() == 2 * sizeof(std::uint32_t) + 9 + 36 + 2);
+        char buf[64] = {};
+        for (auto i = 0u; i < detail::render_slots; ++i) // reuses every slot
+            rostd::snprintf<"%? %?">(buf, sizeof buf, in_addr{}, uuid{});
+        pack::apply(storage.data(), [&](auto const&... args) {
+            static constexpr auto fmt = build_fmt<"%? %?", in_addr, uuid>();
+            return std::snprintf(buf, sizeof buf, fmt.data, args...);
+        });
+        assert(buf == "192.0.2.1 f81d4fae-7dec-11d0-a765-00a0c91e6bf6"sv);
+    }
+
+#if defined(__SIZEOF_INT128__)
+    { // 128-bit integers are captured as their digits.
+        auto const big = detail::uint128{1} << 100;
+        assert((roundtrip<"%? %? %?">(storage, big, -static_cast<detail::int128>(big),
+                hex(big)) == "1267650600228229401496703205376 "
+                        "-1267650600228229401496703205376 10000000000000000000000000"));
+        assert(storage.size() == 3 * sizeof(std::uint32_t) + 31 + 32 + 26 + 3);
+    }
+#endif
+
+    { // Pointers to char may be kept by reference.
+        static char const text[] = "static text";
+        char const* ptr = text;
+        assert((roundtrip<"%?", char_ptr::reference>(storage, ptr)
+                == "static text"));
+        assert(storage.size() == sizeof ptr);
+    }
+
+    { // The pack fails cleanly if the buffer is too small.
+        auto small = std::array<std::byte, 4>{};
+        assert((packed_args<int, double>::pack(small, 1, 2.0) == 0));
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/log.hpp>
+#include <string>
+#include <string_view>
+
+#if !defined(ROSTD_PRINTX_REGISTRY)
+    #error "this suite must be built with ROSTD_PRINTX_REGISTRY"
+#endif
+
+namespace printx_registry_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+
+// Only ever evaluated at compile time, but registered all the same.
+static_assert(build_fmt<"compile time only %?", unsigned>().data[0] == 'c');
+
+} // namespace compile_time_unit_tests
+
+[[maybe_unused]] void never_called(std::string const& s) {
+    rostd::printf<"never called %? %?\n">(s, 1.5);
+}
+
+constexpr auto log_line = __LINE__ + 2;
+[[maybe_unused]] void never_logged(int fd) {
+    ROSTD_LOG(warning, "never logged %?\n", fd);
+}
+
+} // anonymous namespace
+} // namespace printx_registry_suite
+
+int main() {
+    using rostd::printx::registry::format_record;
+    auto const find = [](std::string_view format) {
+        auto const* found = static_cast<format_record const*>(nullptr);
+        for (auto r = rostd::printx::registry::first(); r; r = r->next)
+            if (format == r->format) found = r;
+        return found;
+    };
+
+    // The registry is complete before any formatting takes place.
+    auto const* ct = find("compile time only %?");
+    assert(ct);
+    assert(std::string_view{ct->transformed} == "compile time only %u");
+    assert(ct->arg_count == 1);
+    assert(std::string_view{ct->arg_types[0]} == "unsigned int");
+    assert(ct->arg_types[1] == nullptr);
+    assert(ct->file == nullptr && ct->line == 0);
+
+    auto const* nc = find("never called %? %?\n");
+    assert(nc);
+    assert(std::string_view{nc->transformed} == "never called %s %g\n");
+    assert(nc->arg_count == 2);
+    assert(std::string_view{nc->arg_types[1]} == "double");
+    assert((nc->id == rostd::printx::format_id<"never called %? %?\n",
+            std::string, double>()));
+    assert(rostd::printx::registry::find(nc->id) == nc);
+    assert(rostd::printx::registry::find(0) == nullptr);
+
+    // Log calls know their source location.
+    auto const* logged = find("%? [printx_registry_suite.cpp:"
+            + std::to_string(printx_registry_suite::log_line) + "] WARNING never logged %?\n");
+    assert(logged && logged->line == printx_registry_suite::log_line);
+    assert(std::string_view{logged->file}.ends_with("printx_registry_suite.cpp"));
+
+    auto const* none = find("no arguments");
+    assert(none && none->arg_count == 0 && none->arg_types[0] == nullptr);
+    char buf[16];
+    rostd::sprintf<"no arguments">(buf);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/printx/runtime.hpp>
+#include <climits>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+enum class Level : short { debug = -1, info = 3 };
+
+namespace printx_runtime_suite {
+namespace { // anonymous
+
+// Formats with a literal format and with the same format given at run time,
+// and checks that they agree.
+template <rostd::printx::literal Fmt, typename... Args>
+bool same(Args const&... args) {
+    char expected[128], actual[128];
+    auto const n = rostd::snprintf<Fmt>(expected, sizeof expected, args...);
+    auto const format = rostd::printx::runtime_format<Args...>{Fmt.data};
+    assert(format);
+    auto const m = format.snprintf(actual, sizeof actual, args...);
+    return n == m && std::string_view{expected} == actual;
+}
+
+} // anonymous namespace
+} // namespace printx_runtime_suite
+
+int main() {
+    using namespace std::literals;
+    using rostd::printx::runtime_format;
+    using printx_runtime_suite::same;
+
+    assert(same<"">());
+    assert(same<"plain, 100%% text">());
+    assert(same<"%? %? %? %?">(0, INT_MIN, ULLONG_MAX, Level::debug));
+    assert(same<"%? %? %? %?">(true, 'x', (signed char)-5, (unsigned short)60000));
+    assert(same<"[%5d] [%-5x] [%#o] [%+d] [%08.3X] [%c]">(42, 42, 8, 7, 255u, 65));
+    assert(same<"[%*d] [%-*.*d] [%.*s]">(6, 7, 4, 3, 7, 2, "text"));
+    assert(same<"[%s] [%8s] [%-8?] [%.2?]">("a", "b"s, "view"sv, (char const*)nullptr));
+    assert(same<"[%p] [%?] [%20p]">(nullptr, (void*)nullptr, (void*)&same<"">));
+    assert(same<"%? %.3f %e %10.4g %a %Lg">(0.1, 3.14159, -2.5e-10, 1e21, 1.0, 0.1L));
+    assert(same<"%?|%x">(std::string(300, 'z'), 255)); // truncated
+
+    { // Rejected formats, with the problem and where it was found.
+        auto const bad = runtime_format<int, char const*>{"id=%d name=%d"};
+        assert(!bad);
+        assert(bad.error() == "format expects argument of different type"sv);
+        assert(bad.error_offset() == 13);
+        char buf[16] = "unchanged";
+        errno = 0;
+        assert(bad.snprintf(buf, sizeof buf, 1, "x") == -1 && errno == EINVAL);
+        assert(buf == ""sv);
+        assert(runtime_format<int>{"%d %d"}.error()
+                == "not enough arguments for format"sv);
+        assert(runtime_format<int*>{"%n"}.error()
+                == "conversion not supported by this output engine"sv);
+        assert(runtime_format<int>{"%1$d"}.error()
+                == "argument positions not supported by this function"sv);
+        assert(runtime_format<int>{"%d"}.error() == nullptr);
+        assert(runtime_format<int>{"%?"}.transformed_format() == "%d");
+    }
+
+    { // Compiled formats are cached by the address of the string.
+        char text[32];
+        std::strcpy(text, "<%?>");
+        using format = runtime_format<int>;
+        auto const first = format::cached(text);
+        assert(format::cached(text) == first);
+        char buf[16];
+        assert(format::cached(text)->snprintf(buf, sizeof buf, 5) == 3);
+        assert(buf == "<5>"sv);
+        std::strcpy(text, "[%x]"); // same address, different format
+        format::cached(text)->snprintf(buf, sizeof buf, 255);
+        assert(buf == "[ff]"sv);
+        assert(!*runtime_format<double>::cached("%d"));
+
+        // A format that has been evicted stays valid while it is held.
+        assert(first->snprintf(buf, sizeof buf, 6) == 3);
+        assert(buf == "<6>"sv);
+    }
+
+    { // Output to a stream.
+        auto const file = std::tmpfile();
+        auto const big = std::string(1000, 'y');
+        auto const format = runtime_format<std::string, int>{"%s=%d\n"};
+        assert(format.fprintf(file, big, 7) == 1003);
+        std::rewind(file);
+        auto contents = std::string(1100, '\0');
+        contents.resize(std::fread(contents.data(), 1, contents.size(), file));
+        assert(contents == big + "=7\n");
+        std::fclose(file);
+    }
+
+    return 0;
+}
@@ -6,6 +6,8 @@
  */
 #include "test.hpp"
 #include <rostd/printx.hpp>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <span>
 #include <string>
@@ -17,12 +19,32 @@ enum class EnumTest2 : unsigned long {};
 enum class EnumTest3 : short {};
 enum class EnumTest4 {};
 
+struct Point { int x, y; };
+struct Place { std::string name; Point at; EnumTest3 floor; };
+
 namespace rostd::printx::detail {
 template <> struct traits<EnumTest4> {
     static constexpr auto spec = "s";
 };
+template <> struct traits<Point> {
+    static constexpr auto fmt = "(%?,%?)";
+    static constexpr auto fwd_args(Point const& p) { return std::tie(p.x, p.y); }
+};
+template <> struct traits<Place> {
+    static constexpr literal fmt = "%s at %? on %02d%%";
+    static constexpr auto fwd_args(Place const& p) {
+        return std::tie(p.name, p.at, p.floor);
+    }
+};
 } // namespace rostd::printx::detail
 
+struct Stats { int count; double mean; char const* name; };
+struct Sample { Point where; std::string label; Stats stats; EnumTest2 kind; };
+struct Empty {};
+template <> inline constexpr bool rostd::printx::print_as_aggregate<Stats> = true;
+template <> inline constexpr bool rostd::printx::print_as_aggregate<Sample> = true;
+template <> inline constexpr bool rostd::printx::print_as_aggregate<Empty> = true;
+
 namespace printx_suite {
 namespace { // anonymous
 namespace compile_time_unit_tests {
@@ -215,6 +237,8 @@ ASSERT("%?",       EnumTest4,              "%s");
 #undef ASSERT
 
 static_assert(fmteq(build_fmt<"no args">().data, "no args"));
+static_assert(fmteq((literal{"[%s] "} + literal{"%d%%"}).data, "[%s] %d%%"));
+static_assert(fmteq(("a" + literal{"b"} + "c").data, "abc"));
 static_assert(fmteq(build_fmt<"%% %%">().data, "%% %%"));
 
 // Guarantee width and precision specifiers work with `int`
@@ -245,6 +269,173 @@ static_assert(fmteq(build_fmt<"a %? b %x c %% d %? e\n", double, unsigned long,
 // Ensure the width specifier can still be used with `std::string_view`:
 static_assert(fmteq(build_fmt<"%*?", int, std::string_view>().data, "%*.*s"));
 
+static_assert(detail::tail_offset("no conversions%%") == 0);
+static_assert(detail::tail_offset("%d %-*.*lld%% tail") == 11);
+static_assert(fmteq(detail::format_head<"%d %5s%% tail">.data, "%d %5s"));
+static_assert(fmteq(detail::format_tail<"%d %5s%% tail">.data, "% tail"));
+
+static_assert(fmteq(rostd::braces<"id={} t={:.3}">.data, "id=%? t=%.3?"));
+static_assert(fmteq(rostd::braces<"{{{}}} 100%">.data, "{%?} 100%%"));
+static_assert(fmteq(rostd::braces<"[{:<8}|{:>+08.2f}|{:#x}|{: d}|{:-}]">.data,
+        "[%-8?|%+08.2f|%#x|% d|%?]"));
+static_assert(fmteq(rostd::braces<"{:s}{:c}{:p}{:e}{:G}">.data, "%s%c%p%e%G"));
+static_assert(detail::lower_braces("{:*^8}", nullptr).st
+        == detail::status::braces_not_supported);
+static_assert(detail::lower_braces("{:{}}", nullptr).st
+        == detail::status::braces_not_supported);
+static_assert(detail::lower_braces("{:L}", nullptr).st
+        == detail::status::braces_not_supported);
+static_assert(detail::lower_braces("{", nullptr).st
+        == detail::status::braces_unmatched);
+static_assert(detail::lower_braces("}", nullptr).st
+        == detail::status::braces_unmatched);
+
+static_assert(fmteq(detail::sequential_fmt<"%2$s=%1$-*3$.*4$d %%">.data,
+        "%s=%-*.*d %%"));
+static_assert(detail::argument_order<"%2$s=%1$-*3$.*4$d">
+        == std::array<std::size_t, 4>{1, 2, 3, 0});
+static_assert(detail::argument_order<"%1$d %1$x"> == std::array<std::size_t, 2>{});
+static_assert(!detail::positional<"%05d %*d %s">);
+static_assert(detail::format_positions<"%0$d">.st
+        == detail::status::format_invalid_position);
+static_assert(detail::format_positions<"%1$d %d">.st
+        == detail::status::format_mixed_positions);
+static_assert(detail::format_positions<"%1$*d">.st
+        == detail::status::format_mixed_positions);
+static_assert(fmteq(rostd::braces<"{1} {0:>8.3}">.data, "%2$? %1$8.3?"));
+static_assert(fmteq(rostd::braces<"{10}">.data, "%11$?"));
+
+static_assert(fmteq(build_fmt<"p=%? %d", Point, int>().data, "p=(%d,%d) %d"));
+static_assert(fmteq(build_fmt<"[%?]", Place>().data, "[%s at (%d,%d) on %02hd%%]"));
+static_assert(fmteq(build_fmt<"%?", Stats>().data, "{%d, %g, %s}"));
+static_assert(fmteq(build_fmt<"%?", Sample>().data,
+        "{(%d,%d), %s, {%d, %g, %s}, %lu}"));
+static_assert(fmteq(build_fmt<"%?", Empty>().data, "{}"));
+static_assert([] {
+    char buffer[32] = {};
+    auto src = "%5?";
+    return detail::appending_transformer{buffer}.transform<Point>(src)
+            == detail::status::composite_needs_plain_conversion;
+}());
+static_assert([] {
+    char buffer[32] = {};
+    auto src = "%?";
+    return detail::appending_transformer{buffer, detail::integer_conversions}
+            .transform<Place>(src) == detail::status::conversion_not_supported;
+}());
+
+static_assert(fmteq(detail::transformed_fmt<"%[, ]?", std::vector<int>>.data,
+        "%[, ]d"));
+static_assert(fmteq(detail::transformed_fmt<"[%[ ]02x]", std::span<unsigned char>>
+        .data, "[%[ ]02hhx]"));
+static_assert(detail::needs_native<"%%[ %2$[,]d">);
+static_assert(!detail::needs_native<"%%[ %d [%s]">);
+static_assert(fmteq(detail::sequential_fmt<"%2$[$]d %1$s">.data, "%[$]d %s"));
+template <typename... Args>
+constexpr auto transform_status(char const* src,
+        unsigned const conversions = native_conversions) {
+    char buffer[32] = {};
+    return detail::appending_transformer{buffer, conversions}
+            .transform<Args...>(src);
+}
+// Strings of other characters keep the traits of types with `c_str()`.
+static_assert(!detail::concepts::element_range<std::wstring>);
+static_assert(!detail::concepts::element_range<std::u16string>);
+static_assert(fmteq(build_fmt<"%?", std::u8string>().data, "%s"));
+static_assert(fmteq(build_fmt<"%?", std::wstring>().data, "%s"));
+static_assert(transform_status<int, Point>("[%*?]")
+        == detail::status::composite_needs_plain_conversion);
+static_assert(transform_status<int, Point>("[%.*?]")
+        == detail::status::composite_needs_plain_conversion);
+static_assert(transform_status<std::vector<int>>("%?")
+        == detail::status::range_needs_conversion);
+static_assert(transform_status<int>("%[, ]d")
+        == detail::status::range_expected);
+static_assert(transform_status<int[2]>("%[%]d")
+        == detail::status::range_invalid_separator);
+static_assert(transform_status<int*[2]>("%[, ]n")
+        == detail::status::conversion_not_supported);
+static_assert(transform_status<std::vector<int>>("%[, ]d",
+        detail::all_conversions) == detail::status::conversion_not_supported);
+static_assert(fmteq(detail::transformed_fmt<"%{json}?", std::string_view>.data,
+        "%{json}.*s"));
+static_assert(transform_status<int>("%{json}d")
+        == detail::status::escape_needs_string);
+static_assert(transform_status<double>("%{json}.2f") == detail::status::correct);
+static_assert(transform_status<double>("%{c}g")
+        == detail::status::escape_needs_string);
+static_assert(transform_status<char>("%{csv}c") == detail::status::correct);
+static_assert(transform_status<char const*>("%{xml}s")
+        == detail::status::escape_unknown);
+static_assert(transform_status<char const*>("%{csv}s", detail::all_conversions)
+        == detail::status::conversion_not_supported);
+
+static_assert(fmteq(build_fmt<"%?", std::chrono::milliseconds>().data, "%ldms"));
+static_assert(fmteq(build_fmt<"%?", std::chrono::duration<int, std::ratio<2, 60>>>()
+        .data, "%d[1/30]s"));
+static_assert(fmteq(build_fmt<"%?", std::chrono::duration<double>>().data, "%gs"));
+static_assert(fmteq(build_fmt<"%?", std::chrono::sys_seconds>().data,
+        "%04d-%02u-%02uT%02u:%02u:%02uZ"));
+static_assert(fmteq(build_fmt<"%?", std::chrono::sys_time<std::chrono::microseconds>>()
+        .data, "%04d-%02u-%02uT%02u:%02u:%02u.%06uZ"));
+static_assert([] {
+    using namespace std::chrono;
+    for (auto d = -800'000; d < 800'000; d += 97) {
+        auto const ymd = year_month_day{sys_days{days{d}}};
+        auto const date = detail::chrono::civil_from_days(d);
+        if (date.year != static_cast<int>(ymd.year())
+                || date.month != static_cast<unsigned>(ymd.month())
+                || date.day != static_cast<unsigned>(ymd.day()))
+            return false;
+    }
+    return true;
+}());
+
+// 128-bit integers render their own text, passed to printf as a string.
+static_assert(fmteq(build_fmt<"%? %-40?|", detail::int128, radix<'x'>>().data,
+        "%s %-40s|"));
+static_assert(!detail::concepts::element_range<std::array<detail::uint128, 2>>);
+// Rendered values of one type share a ring of slots in a printf call.
+static_assert([]<std::size_t... I>(std::index_sequence<I...>) {
+    return detail::fits_render_slots<detail::uint128,
+            decltype(I, detail::uint128{})..., int>();
+}(std::make_index_sequence<detail::render_slots>{}));
+static_assert(![]<std::size_t... I>(std::index_sequence<I...>) {
+    return detail::fits_render_slots<detail::uint128,
+            decltype(I, detail::uint128{})..., radix<'x'>>();
+}(std::make_index_sequence<detail::render_slots + 1>{}));
+// The flags and precision of a number cannot apply to digits passed as text.
+static_assert(transform_status<detail::int128>("%.4?")
+        == detail::status::field_precision_not_allowed);
+static_assert(transform_status<detail::int128>("%08?")
+        == detail::status::flag_not_allowed);
+static_assert(transform_status<detail::uint128>("%+?")
+        == detail::status::flag_not_allowed);
+static_assert(transform_status<detail::int128>("% ?")
+        == detail::status::flag_not_allowed);
+static_assert(transform_status<radix<'x'>>("%#?")
+        == detail::status::flag_not_allowed);
+static_assert(transform_status<detail::int128>("%-8?") == detail::status::correct);
+static_assert([] {
+    char out[64] = {};
+    auto const text = [&](auto const value) {
+        return std::string_view{out,
+                detail::traits<std::remove_const_t<decltype(value)>>::render(out, value)};
+    };
+    auto const max = ~detail::uint128{0};
+    return text(max) == "340282366920938463463374607431768211455"
+        && text(static_cast<detail::int128>(max >> 1))
+            == "170141183460469231731687303715884105727"
+        && text(-static_cast<detail::int128>(max >> 1) - 1)
+            == "-170141183460469231731687303715884105728"
+        && text(detail::uint128{10'000'000'000'000'000'000u} * 7 + 5)
+            == "70000000000000000005"
+        && text(detail::uint128{0}) == "0"
+        && text(hex(max)) == "ffffffffffffffffffffffffffffffff"
+        && text(hex<'X'>(detail::uint128{0xabc} << 64)) == "ABC0000000000000000"
+        && text(octal(max)) == "3777777777777777777777777777777777777777777";
+}());
+
 } // namespace compile_time_unit_tests
 } // anonymous namespace
 } // namespace printx_suite
@@ -275,6 +466,139 @@ int main() {
         assert(buf.data() == std::string_view{"3 -2000 3 1"});
     }
 
+    { // Literal text is written directly, whole or after the last conversion.
+        auto const file = std::tmpfile();
+        assert(rostd::fprintf<"100%% literal\n">(file) == 13);
+        auto const tail = std::string(70, '-') + "%\n";
+        assert(rostd::fprintf<"%? %%%?----------------------------------------"
+                "------------------------------%%\n">(file, 1, 2) == 76);
+        char text[128] = {};
+        std::rewind(file);
+        assert(std::fread(text, 1, sizeof text, file) == 89);
+        assert(text == "100% literal\n1 %2" + tail);
+        std::fclose(file);
+    }
+
+    { // Formats in std::format style.
+        char text[64];
+        rostd::snprintf<rostd::braces<"id={} t={:.3} [{:<5}] {:#x} {{ok}}">>(
+                text, sizeof text, 42, 3.14159, "ab", 255u);
+        assert(text == "id=42 t=3.14 [ab   ] 0xff {ok}"sv);
+    }
+
+    { // Types with a sub-format, spliced into the format.
+        char text[64];
+        auto const place = Place{"home", {3, -4}, EnumTest3{2}};
+        assert(rostd::snprintf<"%? / %?">(text, sizeof text, place, Point{1, 2})
+                == 29);
+        assert(text == "home at (3,-4) on 02% / (1,2)"sv);
+    }
+
+    { // Aggregates that opt in are printed field by field.
+        char text[64];
+        auto const sample = Sample{{1, 2}, "label", {3, 0.5, "mean"},
+                EnumTest2{7}};
+        rostd::snprintf<"%?">(text, sizeof text, sample);
+        assert(text == "{(1,2), label, {3, 0.5, mean}, 7}"sv);
+    }
+
+    { // Argument positions, reordered at compile time.
+        char actual[64];
+        assert(rostd::snprintf<"%2$?|%1$-*3$.*4$d|%1$x">(actual, sizeof actual,
+                42, "name"sv, 6, 3) == 14);
+        assert(actual == "name|042   |2a"sv);
+        assert(rostd::sprintf<"%3$? %1$? %2$?">(actual, 'a', 2.5, "x"s) == 7);
+        assert(actual == "x a 2.5"sv);
+        rostd::snprintf<rostd::braces<"{1}:{0:#x}">>(actual, sizeof actual,
+                255, "id");
+        assert(actual == "id:0xff"sv);
+    }
+
+    { // Ranges of numbers, printed element by element.
+        char text[64];
+        auto const values = std::vector<int>{3, -1, 42};
+        assert(rostd::snprintf<"[%[, ]?]">(text, sizeof text, values) == 11);
+        assert(text == "[3, -1, 42]"sv);
+        double const ratios[] = {0.5, 1.25};
+        rostd::snprintf<"%[|]6.2f|%p">(text, sizeof text, ratios, ratios);
+        assert(std::string_view{text}.starts_with("  0.50|  1.25|0x"));
+        auto const bytes = std::array<unsigned char, 4>{0xde, 0xad, 0, 0xef};
+        rostd::sprintf<"%[]02x">(text, std::span{bytes});
+        assert(text == "dead00ef"sv);
+        rostd::sprintf<"%2$s: %1$[ ]?">(text, std::vector<int>{}, "none");
+        assert(text == "none: "sv);
+        auto const file = std::tmpfile();
+        assert(rostd::fprintf<"%[ ]?\n">(file, values) == 8);
+        std::rewind(file);
+        assert(std::fread(text, 1, sizeof text, file) == 8);
+        assert(std::string_view(text, 8) == "3 -1 42\n");
+        std::fclose(file);
+    }
+
+    { // Hex dumps, encoded a block at a time.
+        auto bytes = std::vector<unsigned char>(300);
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = static_cast<unsigned char>(i * 37 + 11);
+        auto expected = std::string{};
+        for (std::size_t i = 0; i < bytes.size(); ++i) {
+            char pair[4];
+            std::snprintf(pair, sizeof pair, "%02X", bytes[i]);
+            if (i && i % 8 == 0) expected += ' ';
+            expected += pair;
+        }
+        auto actual = std::string(1024, '\0');
+        auto const n = rostd::snprintf<"%8[ ]02X">(actual.data(), actual.size(),
+                bytes);
+        assert(actual.c_str() == expected);
+        assert(n == static_cast<int>(expected.size()));
+        rostd::sprintf<"%2$[]02x %1$[]c">(actual, std::span{bytes}.first(4),
+                std::span{bytes}.last(17));
+        assert(actual.c_str() == "f2173c6186abd0f51a3f6489aed3f81d42 .0Uz"sv);
+    }
+
+    { // Escaped strings, scanned for special characters a block at a time.
+        auto const text = std::string(40, 'x') + "\"quoted\"\n" + std::string(40, 'y');
+        auto const json = std::string(40, 'x') + "\\\"quoted\\\"\\n"
+                + std::string(40, 'y');
+        auto actual = std::string(256, '\0');
+        assert(rostd::sprintf<"%{json}?">(actual, text)
+                == static_cast<int>(json.size()));
+        assert(actual.c_str() == json);
+        rostd::sprintf<"%2${c}?=%1${csv}?">(actual, "a,b"sv, std::string{"\t"});
+        assert(actual.c_str() == "\\t=\"a,b\""sv);
+        auto const file = std::tmpfile();
+        assert(rostd::fprintf<"{\"msg\":\"%{json}s\"}\n">(file, "tab\there") == 20);
+        std::fclose(file);
+    }
+
+    { // Durations and system clock times.
+        using namespace std::chrono;
+        char text[96];
+        rostd::snprintf<"%? %? %? %?">(text, sizeof text, 250ms, -3s, 1.5min,
+                duration<int, std::ratio<1, 30>>{2});
+        assert(text == "250ms -3s 1.5min 2[1/30]s"sv);
+        auto const t = sys_days{2024y / 2 / 29} + 13h + 5min + 7s + 42ms;
+        rostd::snprintf<"%? %?">(text, sizeof text, t, floor<seconds>(t));
+        assert(text == "2024-02-29T13:05:07.042Z 2024-02-29T13:05:07Z"sv);
+        rostd::snprintf<"%?">(text, sizeof text, sys_time<nanoseconds>{-1ns});
+        assert(text == "1969-12-31T23:59:59.999999999Z"sv);
+        auto const file = std::tmpfile();
+        assert(rostd::fprintf<"%{json}s|%?|%?">(file, "x", t, microseconds{5}) == 30);
+        std::fclose(file);
+    }
+
+    { // Constant arguments are formatted at compile time.
+        static constexpr char build_id[] = "abc123";
+        auto const file = std::tmpfile();
+        assert((rostd::fprintf<"build %? (%?) %.2f\n", 7, build_id, 0.125>(file)
+                == 22));
+        char text[32] = {};
+        std::rewind(file);
+        assert(std::fread(text, 1, sizeof text, file) == 22);
+        assert(text == "build 7 (abc123) 0.12\n"sv);
+        std::fclose(file);
+    }
+
     char buf[buffer_size] = {};
 
 #define CHECK_CMP(Val, Fmt, Output) \
@@ -321,6 +645,11 @@ int main() {
     CHECK_CMP(UINT64_MAX,        "%x", "ffffffffffffffff");
     CHECK_CMP(UINT64_MAX,        "%X", "FFFFFFFFFFFFFFFF");
     CHECK_CMP('a',               "%c", "a");
+    CHECK_CMP(static_cast<rostd::printx::detail::int128>(INT64_MIN) * 4,
+                                 "%?", "-36893488147419103232");
+    CHECK_CMP(rostd::printx::octal(UINT64_MAX), "%24?" , "  1777777777777777777777");
+    CHECK_CMP(rostd::printx::detail::int128{-123456}, "[%-8?]", "[-123456 ]");
+    CHECK_CMP(rostd::printx::detail::int128{-123456}, "[%4?]", "[-123456]");
 
     CHECK_CMP("right",           "%10?",  "     right");
     CHECK_CMP("left",            "%-10?", "left      ");
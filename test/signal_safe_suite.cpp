@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2021-2022 Roku, Inc. All rights reserved.
+ * This software and any compilation or derivative thereof is, and shall
+ * remain, the proprietary information of Roku, Inc. and is highly confidential
+ * in nature.
+ */
+#include "test.hpp"
+#include <rostd/signal_safe.hpp>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+enum class Level : short { debug = -1, info = 3 };
+
+namespace signal_safe_suite {
+namespace { // anonymous
+namespace compile_time_unit_tests {
+
+using namespace rostd::printx;
+using namespace rostd::printx::detail;
+
+template <typename... Args>
+constexpr status check(char const* fmt, unsigned const conversions) {
+    char buffer[64] = {};
+    return appending_transformer{buffer, conversions}.transform<Args...>(fmt);
+}
+
+static_assert(check<int, char const*, void*>("%d %s %p", native_conversions)
+        == status::correct);
+static_assert(check<double>("%f", rostd::signal_safe::conversions)
+        == status::conversion_not_supported);
+static_assert(check<double>("%?", rostd::signal_safe::conversions)
+        == status::conversion_not_supported);
+static_assert(check<double>("%?", all_conversions) == status::correct);
+static_assert(check<int>("%d", float_conversions)
+        == status::conversion_not_supported);
+static_assert(check<int>("%1$d", all_conversions)
+        == status::format_positions_not_supported);
+
+static_assert(native::plan<"a%%b%-*.*hhdc">.size() == 3);
+static_assert(native::plan<"a%%b%-*.*hhdc">[1].flags == native::left);
+static_assert(native::plan<"a%%b%-*.*hhdc">[1].width == native::from_arg);
+static_assert(native::plan<"a%%b%-*.*hhdc">[1].size_of == native::length::hh);
+static_assert(native::plan<"a%%b%-*.*hhdc">[2].size == 1);
+
+} // namespace compile_time_unit_tests
+
+// Formats with both engines, and checks that they agree.
+template <rostd::printx::literal Fmt, typename... Args>
+bool same(Args const&... args) {
+    char expected[128], actual[128];
+    auto const n = rostd::snprintf<Fmt>(expected, sizeof expected, args...);
+    std::memset(actual, 0x55, sizeof actual);
+    auto const m = rostd::signal_safe::snprintf<Fmt>(actual, sizeof actual,
+            args...);
+    return n == m && std::string_view{expected} == actual;
+}
+
+int pipe_fds[2];
+
+void handler(int) {
+    rostd::signal_safe::dprintf<"caught signal %? in thread %?\n">(
+            pipe_fds[1], SIGUSR1, 1234);
+}
+
+std::string drain() {
+    char buf[1024];
+    auto const n = ::read(pipe_fds[0], buf, sizeof buf);
+    return n > 0 ? std::string(buf, static_cast<std::size_t>(n)) : "";
+}
+
+} // anonymous namespace
+} // namespace signal_safe_suite
+
+int main() {
+    using namespace std::literals;
+    using signal_safe_suite::same;
+
+    assert(same<"">());
+    assert(same<"plain text, 100%% literal">());
+    assert(same<"%? %? %? %? %?">(0, -1, INT_MIN, INT_MAX, UINT_MAX));
+    assert(same<"%? %?">(LLONG_MIN, ULLONG_MAX));
+    assert(same<"%? %? %? %?">(true, 'x', (signed char)-5, (unsigned char)250));
+    assert(same<"%? %? %?">((short)-300, (unsigned short)60000, Level::debug));
+    assert(same<"%d %u %x %X %o">('\xff', -1, -1, 255, 8));
+    assert(same<"%x %X %o %#x %#X %#o">(0, 0, 0, 0, 0, 0));
+    assert(same<"%#x %#X %#o %#.3o %#.0o">(255, 255, 8, 8, 0));
+    assert(same<"[%5d] [%-5d] [%05d] [%+d] [% d] [%+5d] [%-+5d]">(
+            42, 42, -42, 42, 42, 42, -42));
+    assert(same<"[%.0d] [%.0x] [%5.0d] [%.5d] [%8.5d] [%-8.5x] [%08.5d]">(
+            0, 0, 0, -42, 42, 42, 42));
+    assert(same<"[%012x] [%#012x] [%#-12x] [%+012d]">(
+            0xbeef, 0xbeef, 0xbeef, -12345));
+    assert(same<"[%*d] [%-*d] [%*d] [%.*d] [%.*d]">(
+            6, 7, 6, 7, -6, 7, 4, 7, -4, 7));
+    assert(same<"[%c] [%3c] [%-3c]">('a', 'b', 'c'));
+    assert(same<"[%s] [%8s] [%-8s] [%.2s] [%8.2s]">(
+            "text", "text", "text", "text", "text"));
+    assert(same<"[%?] [%.3?] [%.7?]">((char const*)nullptr,
+            (char const*)nullptr, (char const*)nullptr));
+    assert(same<"[%?] [%10?] [%-10?]">("std::string"s, "view"sv,
+            std::vector<char>{'v', 'e', 'c'}));
+    assert(same<"%3$? %1$*2$? %1$#x">(255, 6, "name"));
+    assert(same<"[%p] [%?] [%20p] [%-20?]">(nullptr, (void*)nullptr,
+            (void*)&pipe, (void*)&pipe));
+
+    { // %n stores the count so far.
+        int n1 = -1, n2 = -1;
+        char buf[32];
+        assert(rostd::signal_safe::snprintf<"abc%n%?%n">(buf, sizeof buf,
+                &n1, 12345, &n2) == 8);
+        assert(n1 == 3 && n2 == 8);
+    }
+
+    { // Output is truncated like snprintf, and always terminated.
+        char buf[6];
+        assert(rostd::signal_safe::snprintf<"%?-%?">(buf, sizeof buf,
+                "abcd", 12345) == 10);
+        assert(buf == "abcd-"sv);
+        assert(rostd::signal_safe::snprintf<"%?">(buf, 0, "abcd") == 4);
+        assert(buf == "abcd-"sv);
+    }
+
+    using signal_safe_suite::pipe_fds;
+    using signal_safe_suite::drain;
+    assert(::pipe(pipe_fds) == 0);
+
+    { // Writing to a file descriptor, in pieces larger than the buffer.
+        auto const big = std::string(1000, 'z');
+        assert(rostd::signal_safe::dprintf<"<%?>%?\n">(pipe_fds[1], big, 7)
+                == 1004);
+        assert(drain() == "<" + big + ">7\n");
+        errno = EDOM;
+        assert(rostd::signal_safe::dprintf<"%?">(pipe_fds[1], 0) == 1);
+        assert(errno == EDOM);
+        assert(drain() == "0");
+        assert(rostd::signal_safe::dprintf<"%?">(-1, 0) == -1);
+    }
+
+    { // In a signal handler.
+        std::signal(SIGUSR1, signal_safe_suite::handler);
+        std::raise(SIGUSR1);
+        assert(drain() == "caught signal 10 in thread 1234\n");
+    }
+
+    return 0;
+}